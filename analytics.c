@@ -0,0 +1,335 @@
+#include "analytics.h"
+#include "api.h"
+#include "timeseries.h"
+#include "quote_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/*
+ * The kernels are written as straight loops over restrict-qualified columns so the
+ * compiler vectorizes them (analytics.o is built with -O3 -fopenmp-simd). On x86-64 GCC also emits
+ * an AVX2 clone of each kernel and picks it at load time when the CPU supports it.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define SIMD_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define SIMD_KERNEL
+#endif
+
+#define TRADING_DAYS_PER_YEAR 252.0
+
+int init_position_buffers(position_buffers *buffers, size_t capacity) {
+    memset(buffers, 0, sizeof(*buffers));
+    if (capacity == 0) capacity = 16;
+
+    buffers->user_id = malloc(capacity * sizeof(int));
+    buffers->symbol = malloc(capacity * SYMBOL_LEN);
+    buffers->quantity = malloc(capacity * sizeof(int64_t));
+    buffers->cost = malloc(capacity * sizeof(money_t));
+    buffers->price = malloc(capacity * sizeof(money_t));
+    buffers->previous_close = malloc(capacity * sizeof(money_t));
+    buffers->market_value = malloc(capacity * sizeof(money_t));
+    buffers->unrealized_pl = malloc(capacity * sizeof(money_t));
+    buffers->weight = malloc(capacity * sizeof(double));
+    buffers->daily_return = malloc(capacity * sizeof(double));
+    buffers->capacity = capacity;
+
+    if (!buffers->user_id || !buffers->symbol || !buffers->quantity || !buffers->cost || !buffers->price ||
+        !buffers->previous_close || !buffers->market_value || !buffers->unrealized_pl || !buffers->weight ||
+        !buffers->daily_return) {
+        free_position_buffers(buffers);
+        return -1;
+    }
+    return 0;
+}
+
+void free_position_buffers(position_buffers *buffers) {
+    free(buffers->user_id);
+    free(buffers->symbol);
+    free(buffers->quantity);
+    free(buffers->cost);
+    free(buffers->price);
+    free(buffers->previous_close);
+    free(buffers->market_value);
+    free(buffers->unrealized_pl);
+    free(buffers->weight);
+    free(buffers->daily_return);
+    memset(buffers, 0, sizeof(*buffers));
+}
+
+static int grow_column(void **column, size_t element_size, size_t capacity) {
+    void *grown = realloc(*column, capacity * element_size);
+    if (grown == NULL) return -1;
+    *column = grown;
+    return 0;
+}
+
+static int grow_position_buffers(position_buffers *buffers) {
+    size_t capacity = buffers->capacity * 2;
+    if (grow_column((void **)&buffers->user_id, sizeof(int), capacity) != 0 ||
+        grow_column((void **)&buffers->symbol, SYMBOL_LEN, capacity) != 0 ||
+        grow_column((void **)&buffers->quantity, sizeof(int64_t), capacity) != 0 ||
+        grow_column((void **)&buffers->cost, sizeof(money_t), capacity) != 0 ||
+        grow_column((void **)&buffers->price, sizeof(money_t), capacity) != 0 ||
+        grow_column((void **)&buffers->previous_close, sizeof(money_t), capacity) != 0 ||
+        grow_column((void **)&buffers->market_value, sizeof(money_t), capacity) != 0 ||
+        grow_column((void **)&buffers->unrealized_pl, sizeof(money_t), capacity) != 0 ||
+        grow_column((void **)&buffers->weight, sizeof(double), capacity) != 0 ||
+        grow_column((void **)&buffers->daily_return, sizeof(double), capacity) != 0) {
+        return -1;
+    }
+    buffers->capacity = capacity;
+    return 0;
+}
+
+int add_position(position_buffers *buffers, int user_id, const char *symbol, int64_t quantity, money_t cost) {
+    if (buffers->count == buffers->capacity && grow_position_buffers(buffers) != 0) {
+        return -1;
+    }
+    size_t i = buffers->count++;
+    buffers->user_id[i] = user_id;
+    snprintf(buffers->symbol[i], SYMBOL_LEN, "%s", symbol);
+    buffers->quantity[i] = quantity;
+    buffers->cost[i] = cost;
+    buffers->price[i] = 0;
+    buffers->previous_close[i] = 0;
+    return 0;
+}
+
+static int load_positions(sqlite3 *db, const char *sql, int user_id, position_buffers *buffers) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare portfolio query: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+    if (user_id >= 0) {
+        sqlite3_bind_int(stmt, 1, user_id);
+    }
+
+    int rc = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (add_position(buffers, sqlite3_column_int(stmt, 0), (const char *)sqlite3_column_text(stmt, 1),
+                         sqlite3_column_int64(stmt, 2), sqlite3_column_int64(stmt, 3)) != 0) {
+            fprintf(stderr, "Out of memory loading positions.\n");
+            rc = -1;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int load_user_positions(sqlite3 *db, int user_id, position_buffers *buffers) {
+    return load_positions(db, "SELECT user_id, stock_symbol, quantity, purchase_price FROM portfolio WHERE user_id = ?;",
+                          user_id, buffers);
+}
+
+int load_all_positions(sqlite3 *db, position_buffers *buffers) {
+    return load_positions(db, "SELECT user_id, stock_symbol, quantity, purchase_price FROM portfolio ORDER BY user_id;",
+                          -1, buffers);
+}
+
+static _Thread_local const position_buffers *sort_buffers;     /* qsort has no context argument */
+
+static int compare_symbol_rows(const void *a, const void *b) {
+    return strcmp(sort_buffers->symbol[*(const size_t *)a], sort_buffers->symbol[*(const size_t *)b]);
+}
+
+/* One quote per distinct symbol, however many portfolios hold it, from the quote cache when fresh.
+ * Unpriced rows keep price 0. */
+int load_position_quotes(position_buffers *buffers) {
+    size_t n = buffers->count;
+    if (n == 0) return 0;
+
+    size_t *order = malloc(n * sizeof(size_t));
+    if (order == NULL) return -1;
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    sort_buffers = buffers;
+    qsort(order, n, sizeof(size_t), compare_symbol_rows);
+
+    int failures = 0;
+    for (size_t i = 0; i < n;) {
+        const char *symbol = buffers->symbol[order[i]];
+        stock_quote quote = { 0, 0 };
+        if (cached_stock_quote(symbol, &quote) != 0) {
+            failures++;
+        }
+        for (; i < n && strcmp(buffers->symbol[order[i]], symbol) == 0; i++) {
+            buffers->price[order[i]] = quote.current;
+            buffers->previous_close[order[i]] = quote.previous_close;
+        }
+    }
+
+    free(order);
+    return failures;
+}
+
+SIMD_KERNEL
+void compute_position_values(const int64_t *restrict quantity, const money_t *restrict price, const money_t *restrict cost,
+                             money_t *restrict market_value, money_t *restrict unrealized_pl, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        market_value[i] = quantity[i] * price[i];
+        unrealized_pl[i] = quantity[i] * (price[i] - cost[i]);
+    }
+}
+
+SIMD_KERNEL
+money_t sum_money(const money_t *restrict values, size_t count) {
+    money_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+SIMD_KERNEL
+void compute_weights(const money_t *restrict market_value, money_t total, double *restrict weight, size_t count) {
+    double scale = total != 0 ? 1.0 / (double)total : 0.0;
+    for (size_t i = 0; i < count; i++) {
+        weight[i] = (double)market_value[i] * scale;
+    }
+}
+
+SIMD_KERNEL
+void compute_daily_returns(const money_t *restrict price, const money_t *restrict previous_close,
+                           double *restrict daily_return, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        double previous = (double)previous_close[i];
+        double ratio = (double)price[i] / (previous > 0.0 ? previous : 1.0);
+        daily_return[i] = previous > 0.0 ? ratio - 1.0 : 0.0;
+    }
+}
+
+SIMD_KERNEL
+double dot_product(const double *restrict a, const double *restrict b, size_t count) {
+    double total = 0.0;
+#pragma omp simd reduction(+:total)
+    for (size_t i = 0; i < count; i++) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+/* Standard deviation of close-to-close returns, scaled to a year of trading days. */
+SIMD_KERNEL
+double annualized_volatility(const money_t *restrict close, size_t count) {
+    if (count < 3) return 0.0;
+    double sum = 0.0, sum_sq = 0.0;
+#pragma omp simd reduction(+:sum, sum_sq)
+    for (size_t i = 1; i < count; i++) {
+        double r = (double)close[i] / (double)close[i - 1] - 1.0;
+        sum += r;
+        sum_sq += r * r;
+    }
+    double n = (double)(count - 1);
+    double variance = (sum_sq - sum * sum / n) / (n - 1.0);
+    return variance > 0.0 ? sqrt(variance * TRADING_DAYS_PER_YEAR) : 0.0;
+}
+
+/* Largest absolute value in a column, as unsigned so INT64_MIN has one. */
+SIMD_KERNEL
+static uint64_t max_magnitude(const int64_t *restrict values, size_t count) {
+    uint64_t largest = 0;
+#pragma omp simd reduction(max:largest)
+    for (size_t i = 0; i < count; i++) {
+        uint64_t magnitude = values[i] < 0 ? 0 - (uint64_t)values[i] : (uint64_t)values[i];
+        largest = magnitude > largest ? magnitude : largest;
+    }
+    return largest;
+}
+
+/*
+ * compute_position_values() and sum_money() use plain int64 arithmetic so they vectorize.
+ * Every product there is at most max|quantity| * (max|price| + max|cost|) in magnitude and
+ * every sum at most count times that, so checking that bound once up front is enough.
+ */
+static int position_values_fit(const position_buffers *buffers) {
+    size_t n = buffers->count;
+    uint64_t quantity = max_magnitude(buffers->quantity, n);
+    uint64_t spread, bound;
+    return !__builtin_add_overflow(max_magnitude(buffers->price, n), max_magnitude(buffers->cost, n), &spread) &&
+           !__builtin_mul_overflow(quantity, spread, &bound) && !__builtin_mul_overflow(bound, (uint64_t)n, &bound) &&
+           bound <= INT64_MAX;
+}
+
+/*
+ * Values every row, then splits the rows into per-user segments (rows are grouped
+ * by user_id) and fills weights and one summary per user.
+ */
+int analyze_positions(position_buffers *buffers, portfolio_summary **summaries, size_t *summary_count) {
+    size_t n = buffers->count;
+    if (!position_values_fit(buffers)) {
+        fprintf(stderr, "Position values are too large to total.\n");
+        return -1;
+    }
+    compute_position_values(buffers->quantity, buffers->price, buffers->cost,
+                            buffers->market_value, buffers->unrealized_pl, n);
+    compute_daily_returns(buffers->price, buffers->previous_close, buffers->daily_return, n);
+
+    size_t users = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || buffers->user_id[i] != buffers->user_id[i - 1]) users++;
+    }
+
+    portfolio_summary *out = calloc(users ? users : 1, sizeof(portfolio_summary));
+    if (out == NULL) return -1;
+
+    size_t u = 0;
+    for (size_t first = 0; first < n; u++) {
+        size_t last = first;
+        while (last < n && buffers->user_id[last] == buffers->user_id[first]) last++;
+        size_t count = last - first;
+
+        portfolio_summary *summary = &out[u];
+        summary->user_id = buffers->user_id[first];
+        summary->first = first;
+        summary->count = count;
+        summary->market_value = sum_money(buffers->market_value + first, count);
+        summary->unrealized_pl = sum_money(buffers->unrealized_pl + first, count);
+        summary->cost_basis = summary->market_value - summary->unrealized_pl;
+        compute_weights(buffers->market_value + first, summary->market_value, buffers->weight + first, count);
+        summary->daily_return = dot_product(buffers->weight + first, buffers->daily_return + first, count);
+        first = last;
+    }
+
+    *summaries = out;
+    *summary_count = users;
+    return 0;
+}
+
+/*
+ * Volatility of the segment's current holdings replayed over the last `days` stored
+ * daily closes. Symbols without history are left out; 0 means no usable history.
+ */
+double portfolio_volatility(const position_buffers *buffers, size_t first, size_t count, int days) {
+    if (days < 3) return 0.0;
+    money_t *values = calloc((size_t)days, sizeof(money_t));
+    if (values == NULL) return 0.0;
+
+    size_t length = (size_t)days;
+    int64_t now = (int64_t)time(NULL);
+    int priced = 0;
+    for (size_t i = first; i < first + count; i++) {
+        candle_series series;
+        candle_range range;
+        if (open_candle_series(buffers->symbol[i], &series) != 0) continue;
+        if (query_candle_range(&series, now - (int64_t)days * 86400, INT64_MAX, &range) == 0 && range.count >= 3) {
+            if (range.count < length) length = range.count;
+            const money_t *close = range.close + range.count - length;
+            int64_t quantity = buffers->quantity[i];
+            size_t offset = (size_t)days - length;
+            for (size_t t = 0; t < length; t++) {
+                values[offset + t] += quantity * close[t];
+            }
+            priced++;
+        }
+        close_candle_series(&series);
+    }
+
+    double volatility = priced ? annualized_volatility(values + (size_t)days - length, length) : 0.0;
+    free(values);
+    return volatility;
+}
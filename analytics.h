@@ -0,0 +1,60 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sqlite3.h>
+#include "money.h"
+
+#define SYMBOL_LEN 16
+
+/*
+ * Positions in struct-of-arrays form: one contiguous column per field, so the
+ * valuation kernels below run over plain arrays and vectorize.
+ */
+typedef struct {
+    size_t count;
+    size_t capacity;
+    int *user_id;
+    char (*symbol)[SYMBOL_LEN];
+    int64_t *quantity;
+    money_t *cost;              /* average purchase price */
+    money_t *price;             /* current price */
+    money_t *previous_close;
+
+    money_t *market_value;
+    money_t *unrealized_pl;
+    double *weight;             /* of the owning user's market value */
+    double *daily_return;
+} position_buffers;
+
+typedef struct {
+    int user_id;
+    size_t first;               /* this user's rows are [first, first + count) */
+    size_t count;
+    money_t cost_basis;
+    money_t market_value;
+    money_t unrealized_pl;
+    double daily_return;
+} portfolio_summary;
+
+int init_position_buffers(position_buffers *buffers, size_t capacity);
+void free_position_buffers(position_buffers *buffers);
+int add_position(position_buffers *buffers, int user_id, const char *symbol, int64_t quantity, money_t cost);
+
+int load_user_positions(sqlite3 *db, int user_id, position_buffers *buffers);
+int load_all_positions(sqlite3 *db, position_buffers *buffers);
+int load_position_quotes(position_buffers *buffers);
+
+void compute_position_values(const int64_t *quantity, const money_t *price, const money_t *cost,
+                             money_t *market_value, money_t *unrealized_pl, size_t count);
+money_t sum_money(const money_t *values, size_t count);
+void compute_weights(const money_t *market_value, money_t total, double *weight, size_t count);
+void compute_daily_returns(const money_t *price, const money_t *previous_close, double *daily_return, size_t count);
+double dot_product(const double *a, const double *b, size_t count);
+double annualized_volatility(const money_t *close, size_t count);
+
+int analyze_positions(position_buffers *buffers, portfolio_summary **summaries, size_t *summary_count);
+double portfolio_volatility(const position_buffers *buffers, size_t first, size_t count, int days);
+
+#endif
@@ -1,11 +1,19 @@
 #include "api.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
 #include <curl/curl.h>
 #include "cJSON.h"
+#include "finnhub_decoders.h"
+#include "latency.h"
 
 #define FINNHUB_API_KEY "ctalvipr01qrt5hi060gctalvipr01qrt5hi0610"
+#define CONNECT_TIMEOUT_SECONDS 10
+#define TRANSFER_TIMEOUT_SECONDS 30
 
 struct string {
     char *ptr;
@@ -35,121 +43,401 @@ size_t writefunc(void *ptr, size_t size, size_t nmemb, struct string *s) {
     return size * nmemb;
 }
 
-int fetch_stock_details(const char *exchange) {
-    CURL *curl;
-    CURLcode res;
-    struct string s;
+static _Thread_local int quiet;
 
-    init_string(&s);
+void api_set_quiet(int enabled) {
+    quiet = enabled;
+}
+
+static void report_error(const char *format, ...) {
+    if (quiet) return;
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+static _Thread_local atomic_int *abort_flag;
+
+void api_set_abort_flag(atomic_int *flag) {
+    abort_flag = flag;
+}
+
+static int check_abort(void *data, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    (void)data;
+    (void)dltotal;
+    (void)dlnow;
+    (void)ultotal;
+    (void)ulnow;
+    return atomic_load(abort_flag) != 0;
+}
+
+static CURLcode transfer(const char *url, curl_write_callback write, void *data) {
+    if (abort_flag != NULL && atomic_load(abort_flag)) return CURLE_ABORTED_BY_CALLBACK;
 
-    curl = curl_easy_init();
+    CURL *curl = curl_easy_init();
     if (!curl) {
-        fprintf(stderr, "Failed to initialize CURL.\n");
-        return -1;
+        report_error("Failed to initialize CURL.\n");
+        return CURLE_FAILED_INIT;
     }
 
-    char url[256];
-    snprintf(url, sizeof(url), "https://finnhub.io/api/v1/stock/symbol?exchange=%s&token=%s", exchange, FINNHUB_API_KEY);
-
     curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, data);
+    /* several threads fetch, so no SIGALRM-based DNS timeouts; and no transfer may hang a logout */
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, (long)CONNECT_TIMEOUT_SECONDS);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, (long)TRANSFER_TIMEOUT_SECONDS);
+    if (abort_flag != NULL) {
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, check_abort);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    return res;
+}
 
-    res = curl_easy_perform(curl);
+static int perform_request(const char *url, struct string *s) {
+    uint64_t start = latency_now();
+    CURLcode res = transfer(url, (curl_write_callback)writefunc, s);
+    latency_record(LAT_HTTP, start);
     if (res != CURLE_OK) {
-        fprintf(stderr, "CURL Error: %s\n", curl_easy_strerror(res));
-        curl_easy_cleanup(curl);
-        free(s.ptr);
+        if (res != CURLE_FAILED_INIT && res != CURLE_ABORTED_BY_CALLBACK) {
+            report_error("CURL Error: %s\n", curl_easy_strerror(res));
+        }
         return -1;
     }
+    return 0;
+}
 
-    curl_easy_cleanup(curl);
+typedef struct {
+    cJSON_Stream *stream;
+    int status;
+    uint64_t parse_ns;          /* time spent in cJSON_StreamFeed over all chunks */
+} stream_body;
 
-    cJSON *json = cJSON_Parse(s.ptr);
-    if (!json) {
-        fprintf(stderr, "Failed to parse JSON response.\n");
-        free(s.ptr);
+static size_t stream_writefunc(char *ptr, size_t size, size_t nmemb, void *data) {
+    stream_body *body = data;
+    uint64_t start = latency_now();
+    body->status = cJSON_StreamFeed(body->stream, ptr, size * nmemb);
+    body->parse_ns += latency_now() - start;
+    /* A short count aborts the transfer: the callback has what it needs or the body is malformed. */
+    return body->status == 0 ? size * nmemb : 0;
+}
+
+/* Parses a top-level array response element by element while it downloads. */
+static int perform_stream_request(const char *url, cJSON_StreamCallback callback, void *user_data) {
+    stream_body body = { cJSON_CreateStream(callback, user_data), 0, 0 };
+    if (body.stream == NULL) {
+        report_error("Out of memory.\n");
         return -1;
     }
 
-    if (!cJSON_IsArray(json)) {
-        fprintf(stderr, "Unexpected response format.\n");
-        cJSON_Delete(json);
-        free(s.ptr);
-        return -1;
+    /* the whole streamed download; the parsing inside it is summed and recorded once as a document parse */
+    uint64_t start = latency_now();
+    CURLcode res = transfer(url, stream_writefunc, &body);
+    start = latency_record(LAT_HTTP, start);
+    int rc = 0;
+    if (body.status < 0) {
+        report_error("Failed to parse JSON response.\n");
+        rc = -1;
+    } else if (res != CURLE_OK && !(res == CURLE_WRITE_ERROR && body.status == 1)) {
+        if (res != CURLE_FAILED_INIT && res != CURLE_ABORTED_BY_CALLBACK) {
+            report_error("CURL Error: %s\n", curl_easy_strerror(res));
+        }
+        rc = -1;
+    } else if (cJSON_StreamFinish(body.stream) < 0) {
+        report_error("Truncated JSON response.\n");
+        rc = -1;
     }
+    latency_record_value(LAT_JSON_PARSE, body.parse_ns + (latency_now() - start));
 
-    printf("Available Stocks:\n");
-    int count = 0;
-    printf("\nSymbol \t| Price \n-------------------\n");
-    for (cJSON *item = json->child; item != NULL && count < 15; item = item->next) {
-        cJSON *symbol = cJSON_GetObjectItem(item, "symbol");
-        if (symbol && cJSON_IsString(symbol)) {
-            double price;
-            if (fetch_stock_price(symbol->valuestring, &price) == 0) {
-                if (price != 0.00){
+    cJSON_DeleteStream(body.stream);
+    return rc;
+}
+
+/*
+ * Local stand-in for Finnhub, enabled with STOCKSIM_LOCAL_API=1 or api_set_local_mode(1).
+ * Prices are a deterministic function of (symbol, time), so quotes and candles agree
+ * with each other and runs are reproducible without network access.
+ */
+static int local_mode = -1;
+
+static const char *local_symbols[] = {
+    "AAPL", "MSFT", "AMZN", "GOOGL", "META", "NVDA", "TSLA", "JPM",
+    "V", "JNJ", "WMT", "PG", "XOM", "KO", "DIS", NULL
+};
 
-                printf("%s \t| $%.2f\n", symbol->valuestring, price);
-                }
-            }
-        count++;
+void api_set_local_mode(int enabled) {
+    local_mode = enabled ? 1 : 0;
+}
+
+int api_local_mode(void) {
+    if (local_mode < 0) {
+        const char *env = getenv("STOCKSIM_LOCAL_API");
+        local_mode = (env != NULL && strcmp(env, "0") != 0 && env[0] != '\0') ? 1 : 0;
     }
+    return local_mode;
 }
 
-    cJSON_Delete(json);
-    free(s.ptr);
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static uint64_t symbol_hash(const char *symbol) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)symbol; *p; p++) {
+        h = (h ^ *p) * 0x100000001b3ULL;
+    }
+    return mix64(h);
+}
+
+static double unit_interval(uint64_t h) {
+    return (double)(h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static money_t local_price_at(const char *symbol, int64_t timestamp) {
+    uint64_t h = symbol_hash(symbol);
+    double base = 20.0 + unit_interval(h) * 480.0;
+    double phase = unit_interval(mix64(h)) * 6.283185307179586;
+    double days = (double)timestamp / 86400.0;
+    double trend = 0.20 * sin(days / 45.0 + phase) + 0.06 * sin(days / 6.0 + 2.0 * phase);
+    double noise = (unit_interval(mix64(h ^ (uint64_t)(timestamp / 60))) - 0.5) * 0.01;
+    double price = base * exp(trend + noise);
+    return money_from_double(floor(price * 100.0 + 0.5) / 100.0);
+}
+
+static int resolution_seconds(const char *resolution) {
+    if (strcmp(resolution, "D") == 0) return 86400;
+    if (strcmp(resolution, "W") == 0) return 7 * 86400;
+    if (strcmp(resolution, "M") == 0) return 30 * 86400;
+    int minutes = atoi(resolution);
+    return minutes > 0 ? minutes * 60 : -1;
+}
+
+static int local_candles(const char *symbol, int step, int64_t from, int64_t to, candle_t **candles, size_t *count) {
+    int64_t first = (from + step - 1) / step * step;
+    size_t n = (to >= first) ? (size_t)((to - first) / step + 1) : 0;
+    candle_t *out = malloc((n ? n : 1) * sizeof(candle_t));
+    if (out == NULL) return -1;
+
+    uint64_t h = symbol_hash(symbol);
+    for (size_t i = 0; i < n; i++) {
+        int64_t t = first + (int64_t)i * step;
+        uint64_t r = mix64(h ^ (uint64_t)t);
+        money_t open = local_price_at(symbol, t);
+        money_t close = local_price_at(symbol, t + step - 1);
+        money_t hi = open > close ? open : close;
+        money_t lo = open < close ? open : close;
+        out[i].timestamp = t;
+        out[i].open = open;
+        out[i].close = close;
+        out[i].high = hi + (money_t)((double)hi * 0.01 * unit_interval(r));
+        out[i].low = lo - (money_t)((double)lo * 0.01 * unit_interval(mix64(r)));
+        out[i].volume = 100000 + (int64_t)(r % 5000000);
+    }
+
+    *candles = out;
+    *count = n;
     return 0;
 }
 
+#define LISTED_SYMBOLS 15
 
-int fetch_stock_price(const char *symbol, double *price) {
-    CURL *curl;
-    CURLcode res;
-    struct string s;
+typedef struct {
+    char symbols[LISTED_SYMBOLS][32];
+    int count;
+} symbol_list;
 
-    init_string(&s);
+/* Takes the first LISTED_SYMBOLS symbols, then stops the download of the (large) listing. */
+static cJSON_bool collect_symbol(cJSON *element, void *user_data) {
+    symbol_list *list = user_data;
+    const cJSON *symbol = cJSON_GetObjectItem(element, "symbol");
+    if (cJSON_IsString(symbol) && strlen(symbol->valuestring) < sizeof(list->symbols[0])) {
+        strcpy(list->symbols[list->count++], symbol->valuestring);
+    }
+    return list->count < LISTED_SYMBOLS;
+}
 
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "Failed to initialize CURL.\n");
+static int list_stocks(const char *exchange) {
+    if (api_local_mode()) {
+        printf("Available Stocks:\n");
+        printf("\nSymbol \t| Price \n-------------------\n");
+        for (int i = 0; local_symbols[i] != NULL; i++) {
+            char price_buf[MONEY_STR_LEN];
+            money_t price = local_price_at(local_symbols[i], (int64_t)time(NULL));
+            printf("%s \t| $%s\n", local_symbols[i], money_format(price, price_buf));
+        }
+        return 0;
+    }
+
+    char url[256];
+    snprintf(url, sizeof(url), "https://finnhub.io/api/v1/stock/symbol?exchange=%s&token=%s", exchange, FINNHUB_API_KEY);
+
+    symbol_list list = { .count = 0 };
+    if (perform_stream_request(url, collect_symbol, &list) != 0) {
+        return -1;
+    }
+    if (list.count == 0) {
+        report_error("Unexpected response format.\n");
         return -1;
     }
 
+    printf("Available Stocks:\n");
+    printf("\nSymbol \t| Price \n-------------------\n");
+    for (int i = 0; i < list.count; i++) {
+        money_t price;
+        if (fetch_stock_price(list.symbols[i], &price) == 0 && price != 0) {
+            char price_buf[MONEY_STR_LEN];
+            printf("%s \t| $%s\n", list.symbols[i], money_format(price, price_buf));
+        }
+    }
+
+    return 0;
+}
+
+
+static int request_quote(const char *symbol, stock_quote *quote) {
+    struct string s;
+
+    if (api_local_mode()) {
+        int64_t now = (int64_t)time(NULL);
+        quote->current = local_price_at(symbol, now);
+        quote->previous_close = local_price_at(symbol, now - now % 86400 - 1);
+        return 0;
+    }
+
+    init_string(&s);
+
     char url[256];
     snprintf(url, sizeof(url), "https://finnhub.io/api/v1/quote?symbol=%s&token=%s", symbol, FINNHUB_API_KEY);
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
-
-    res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "CURL Error: %s\n", curl_easy_strerror(res));
-        curl_easy_cleanup(curl);
+    if (perform_request(url, &s) != 0) {
         free(s.ptr);
         return -1;
     }
 
-    curl_easy_cleanup(curl);
-
-    cJSON *json = cJSON_Parse(s.ptr);
-    if (!json) {
-        fprintf(stderr, ".\n");
+    finnhub_quote decoded;
+    uint64_t start = latency_now();
+    int rc = decode_finnhub_quote(s.ptr, s.len, &decoded);
+    latency_record(LAT_JSON_PARSE, start);
+    if (rc != 0 || !(decoded.present & FINNHUB_QUOTE_HAS_CURRENT)) {
+        report_error("Invalid response.\n");
         free(s.ptr);
         return -1;
     }
 
-    cJSON *current_price = cJSON_GetObjectItem(json, "c");
-    if (current_price && cJSON_IsNumber(current_price)) {
-        *price = current_price->valuedouble;
+    quote->current = decoded.current;
+    if (decoded.present & FINNHUB_QUOTE_HAS_PREVIOUS_CLOSE) {
+        quote->previous_close = decoded.previous_close;
     } else {
-        fprintf(stderr, "Invalid response.\n");
-        cJSON_Delete(json);
+        quote->previous_close = quote->current;
+    }
+
+    free(s.ptr);
+    return 0;
+}
+
+int fetch_stock_quote(const char *symbol, stock_quote *quote) {
+    uint64_t start = latency_now();
+    int rc = request_quote(symbol, quote);
+    latency_record(LAT_FETCH_QUOTE, start);
+    return rc;
+}
+
+int fetch_stock_price(const char *symbol, money_t *price) {
+    uint64_t start = latency_now();
+    stock_quote quote;
+    int rc = fetch_stock_quote(symbol, &quote);
+    if (rc == 0) *price = quote.current;
+    latency_record(LAT_FETCH_PRICE, start);
+    return rc;
+}
+
+static int request_candles(const char *symbol, const char *resolution, int64_t from, int64_t to, candle_t **candles, size_t *count) {
+    struct string s;
+
+    int step = resolution_seconds(resolution);
+    if (step <= 0) {
+        report_error("Unsupported candle resolution: %s\n", resolution);
+        return -1;
+    }
+
+    if (api_local_mode()) {
+        return local_candles(symbol, step, from, to, candles, count);
+    }
+
+    init_string(&s);
+
+    char url[256];
+    snprintf(url, sizeof(url), "https://finnhub.io/api/v1/stock/candle?symbol=%s&resolution=%s&from=%lld&to=%lld&token=%s",
+             symbol, resolution, (long long)from, (long long)to, FINNHUB_API_KEY);
+
+    if (perform_request(url, &s) != 0) {
         free(s.ptr);
         return -1;
     }
 
-    cJSON_Delete(json);
+    finnhub_candles decoded;
+    uint64_t start = latency_now();
+    int rc = decode_finnhub_candles(s.ptr, s.len, &decoded);
+    latency_record(LAT_JSON_PARSE, start);
     free(s.ptr);
+    if (rc != 0) {
+        report_error("Failed to parse candle response.\n");
+        return -1;
+    }
+
+    if (strcmp(decoded.status, "no_data") == 0) {
+        free_finnhub_candles(&decoded);
+        *candles = NULL;
+        *count = 0;
+        return 0;
+    }
+
+    size_t n = decoded.timestamp_count;
+    if (strcmp(decoded.status, "ok") != 0 || !(decoded.present & FINNHUB_CANDLES_HAS_TIMESTAMP) ||
+        decoded.open_count != n || decoded.high_count != n || decoded.low_count != n ||
+        decoded.close_count != n || decoded.volume_count != n) {
+        report_error("Invalid candle response.\n");
+        free_finnhub_candles(&decoded);
+        return -1;
+    }
+
+    candle_t *out = malloc((n ? n : 1) * sizeof(candle_t));
+    if (out == NULL) {
+        free_finnhub_candles(&decoded);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i].timestamp = decoded.timestamp[i];
+        out[i].open = decoded.open[i];
+        out[i].high = decoded.high[i];
+        out[i].low = decoded.low[i];
+        out[i].close = decoded.close[i];
+        out[i].volume = decoded.volume[i];
+    }
+
+    free_finnhub_candles(&decoded);
+    *candles = out;
+    *count = n;
     return 0;
 }
+
+int fetch_stock_candles(const char *symbol, const char *resolution, int64_t from, int64_t to, candle_t **candles, size_t *count) {
+    uint64_t start = latency_now();
+    int rc = request_candles(symbol, resolution, from, to, candles, count);
+    latency_record(LAT_FETCH_CANDLES, start);
+    return rc;
+}
+
+int fetch_stock_details(const char *exchange) {
+    uint64_t start = latency_now();
+    int rc = list_stocks(exchange);
+    latency_record(LAT_FETCH_DETAILS, start);
+    return rc;
+}
@@ -1,7 +1,36 @@
 #ifndef API_H
 #define API_H
 
-int fetch_stock_price(const char *symbol, double *price);
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "money.h"
+
+typedef struct {
+    int64_t timestamp;
+    money_t open;
+    money_t high;
+    money_t low;
+    money_t close;
+    int64_t volume;
+} candle_t;
+
+typedef struct {
+    money_t current;
+    money_t previous_close;
+} stock_quote;
+
+int fetch_stock_price(const char *symbol, money_t *price);
+int fetch_stock_quote(const char *symbol, stock_quote *quote);
 int fetch_stock_details(const char *exchange);
+int fetch_stock_candles(const char *symbol, const char *resolution, int64_t from, int64_t to, candle_t **candles, size_t *count);
+
+void api_set_local_mode(int enabled);
+int api_local_mode(void);
+
+/* Fetch errors on the calling thread are not printed (the caller still sees the -1). */
+void api_set_quiet(int enabled);
+/* Transfers made by the calling thread give up (within about a second) once *flag is nonzero. */
+void api_set_abort_flag(atomic_int *flag);
 
 #endif 
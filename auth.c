@@ -1,28 +1,164 @@
 #include "auth.h"
 #include "database.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
 #include <openssl/sha.h>
+#include "hash_pool.h"
+#include "username_index.h"
+#include "latency.h"
 #define RED "\033[31m"
 #define GREEN "\033[32m"
 #define RESET_COLOR "\033[0m"
 
-void hash_password(const char *password, char *hashed_password) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)password, strlen(password), hash);
-    for(int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(hashed_password + (i * 2), "%02x", hash[i]);
+static void hex_encode(const unsigned char *bytes, size_t count, char *out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < count; i++) {
+        out[2 * i] = digits[bytes[i] >> 4];
+        out[2 * i + 1] = digits[bytes[i] & 0xF];
     }
-    hashed_password[64] = 0; 
+    out[2 * count] = '\0';
 }
 
-int signup(const char *username, const char *password) {
+static int hex_decode(const char *hex, unsigned char *bytes, size_t count) {
+    for (size_t i = 0; i < 2 * count; i++) {
+        char ch = hex[i];
+        int nibble;
+        if (ch >= '0' && ch <= '9') nibble = ch - '0';
+        else if (ch >= 'a' && ch <= 'f') nibble = ch - 'a' + 10;
+        else return -1;
+        bytes[i / 2] = (unsigned char)(i % 2 ? (bytes[i / 2] << 4) | nibble : nibble);
+    }
+    return hex[2 * count] == '\0' ? 0 : -1;
+}
+
+/*
+ * Passwords are stored as "pbkdf2-sha256$<iterations>$<salt hex>$<key hex>"
+ * with a random 16-byte salt. The iteration count is the cost knob: it comes
+ * from set_password_cost() or STOCKSIM_PBKDF2_ITERATIONS, and hashes made with
+ * a different count (or legacy unsalted SHA-256 hex) are re-hashed on the next
+ * successful login. PBKDF2 runs on the hash pool, never on the caller's thread.
+ */
+#define PBKDF2_PREFIX "pbkdf2-sha256$"
+#define SALT_BYTES 16
+#define DEFAULT_PBKDF2_ITERATIONS 600000
+#define MIN_PBKDF2_ITERATIONS 1000
+
+static int pbkdf2_iterations;
+
+typedef struct {
+    hash_task task;
+    const char *password;
+    unsigned char salt[SALT_BYTES];
+    int iterations;
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    int ok;
+} pbkdf2_task;
+
+static void run_pbkdf2(hash_task *task) {
+    pbkdf2_task *job = (pbkdf2_task *)task;
+    uint64_t start = latency_now();
+    job->ok = PKCS5_PBKDF2_HMAC(job->password, (int)strlen(job->password), job->salt, SALT_BYTES, job->iterations,
+                                EVP_sha256(), sizeof(job->key), job->key) == 1;
+    latency_record(LAT_AUTH_PBKDF2, start);
+}
+
+void set_password_cost(int iterations) {
+    pbkdf2_iterations = iterations < MIN_PBKDF2_ITERATIONS ? MIN_PBKDF2_ITERATIONS : iterations;
+}
+
+int password_cost(void) {
+    if (pbkdf2_iterations == 0) {
+        const char *env = getenv("STOCKSIM_PBKDF2_ITERATIONS");
+        set_password_cost(env != NULL ? atoi(env) : DEFAULT_PBKDF2_ITERATIONS);
+    }
+    return pbkdf2_iterations;
+}
+
+/* Fills in the cost and a fresh salt; the key is computed when the task runs. */
+static int prepare_pbkdf2(pbkdf2_task *job, const char *password, int iterations) {
+    memset(job, 0, sizeof(*job));
+    job->task.run = run_pbkdf2;
+    job->password = password;
+    job->iterations = iterations > 0 ? iterations : password_cost();
+    if (RAND_bytes(job->salt, SALT_BYTES) != 1) {
+        fprintf(stderr, "Failed to generate salt.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void encode_pbkdf2(const pbkdf2_task *job, char *encoded) {
+    char salt_hex[SALT_BYTES * 2 + 1], key_hex[SHA256_DIGEST_LENGTH * 2 + 1];
+    hex_encode(job->salt, SALT_BYTES, salt_hex);
+    hex_encode(job->key, sizeof(job->key), key_hex);
+    snprintf(encoded, PASSWORD_HASH_LEN + 1, PBKDF2_PREFIX "%d$%s$%s", job->iterations, salt_hex, key_hex);
+}
+
+int hash_password(const char *password, int iterations, char *encoded) {
+    pbkdf2_task job;
+    if (prepare_pbkdf2(&job, password, iterations) != 0) return -1;
+
+    int rc = hash_pool_run(&job.task);
+    if (rc != 0) return rc;
+    if (!job.ok) return -1;
+    encode_pbkdf2(&job, encoded);
+    return 0;
+}
+
+/* 1 on a match, 0 on a mismatch, -1 on a malformed hash or AUTH_BUSY. */
+int verify_password(const char *password, const char *encoded, int *needs_upgrade) {
+    unsigned char expected[SHA256_DIGEST_LENGTH];
+    *needs_upgrade = 1;
+
+    if (strncmp(encoded, PBKDF2_PREFIX, strlen(PBKDF2_PREFIX)) != 0) {
+        /* legacy: unsalted SHA-256 hex */
+        unsigned char actual[SHA256_DIGEST_LENGTH];
+        if (hex_decode(encoded, expected, sizeof(expected)) != 0) return -1;
+        SHA256((const unsigned char *)password, strlen(password), actual);
+        return CRYPTO_memcmp(actual, expected, sizeof(expected)) == 0;
+    }
+
+    pbkdf2_task job = { .task.run = run_pbkdf2, .password = password };
+    char *end;
+    const char *fields = encoded + strlen(PBKDF2_PREFIX);
+    long iterations = strtol(fields, &end, 10);
+    if (end == fields || *end != '$' || iterations < 1 || iterations > 100000000 ||
+        strlen(end + 1) != SALT_BYTES * 2 + 1 + SHA256_DIGEST_LENGTH * 2 || end[1 + SALT_BYTES * 2] != '$') {
+        return -1;
+    }
+    char salt_hex[SALT_BYTES * 2 + 1];
+    memcpy(salt_hex, end + 1, SALT_BYTES * 2);
+    salt_hex[SALT_BYTES * 2] = '\0';
+    if (hex_decode(salt_hex, job.salt, SALT_BYTES) != 0 ||
+        hex_decode(end + 2 + SALT_BYTES * 2, expected, sizeof(expected)) != 0) {
+        return -1;
+    }
+    job.iterations = (int)iterations;
+
+    int rc = hash_pool_run(&job.task);
+    if (rc != 0) return rc;
+    if (!job.ok) return -1;
+    *needs_upgrade = job.iterations != password_cost();
+    return CRYPTO_memcmp(job.key, expected, sizeof(expected)) == 0;
+}
+
+static int create_user(const char *username, const char *password) {
+    if (username_taken(username)) return AUTH_TAKEN;
+
+    char hashed_password[PASSWORD_HASH_LEN + 1];
+    int rc = hash_password(password, 0, hashed_password);
+    if (rc != 0) return rc;
+
     sqlite3 *db = open_database();
     if (!db) return -1;
 
-    char hashed_password[65];
-    hash_password(password, hashed_password);
-
     const char *sql = "INSERT INTO users (username, password) VALUES (?, ?);";
     sqlite3_stmt *stmt;
 
@@ -35,27 +171,175 @@ int signup(const char *username, const char *password) {
     sqlite3_bind_text(stmt, 1, username, -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, hashed_password, -1, SQLITE_TRANSIENT);
 
-    int rc = sqlite3_step(stmt);
+    rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
+        int taken = sqlite3_extended_errcode(db) == SQLITE_CONSTRAINT_UNIQUE;
         sqlite3_finalize(stmt);
         close_database(db);
-        return -1;
+        return taken ? AUTH_TAKEN : -1;
     }
 
     sqlite3_finalize(stmt);
     close_database(db);
+    add_username(username);
     return 0;
 }
 
+int signup(const char *username, const char *password) {
+    uint64_t start = latency_now();
+    int rc = create_user(username, password);
+    latency_record(LAT_AUTH_SIGNUP, start);
+    return rc;
+}
 
-int login(const char *username, const char *password, int *user_id) {
+/*
+ * Bulk signup for load tests. Accounts are read BULK_BATCH at a time; every
+ * password in a batch is handed to the hash pool at once (waiting on the
+ * oldest outstanding hash whenever the queue is full), and the batch is then
+ * inserted in one transaction through a single prepared statement. Names
+ * already in the username index are dropped before they cost a hash.
+ */
+#define BULK_BATCH 4096
+
+typedef struct {
+    pbkdf2_task job;
+    char username[64];
+    char password[128];
+    int created;
+} bulk_user;
+
+/* "username,password" with the password running to the end of the line; 0 on a record, 1 to skip the line. */
+static int parse_bulk_line(char *line, bulk_user *user) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#') return 1;
+
+    char *comma = strchr(line, ',');
+    if (comma == NULL || comma == line || comma[1] == '\0' || (size_t)(comma - line) >= sizeof(user->username) ||
+        strlen(comma + 1) >= sizeof(user->password)) {
+        return 1;
+    }
+    memcpy(user->username, line, (size_t)(comma - line));
+    user->username[comma - line] = '\0';
+    snprintf(user->password, sizeof(user->password), "%s", comma + 1);
+    return 0;
+}
+
+static int hash_bulk_batch(bulk_user *users, int count, int iterations) {
+    int submitted = 0, waited = 0, rc = 0;
+    while (submitted < count) {
+        if (prepare_pbkdf2(&users[submitted].job, users[submitted].password, iterations) != 0) {
+            rc = -1;
+            break;
+        }
+        while ((rc = hash_pool_submit(&users[submitted].job.task)) == HASH_POOL_BUSY && waited < submitted) {
+            hash_pool_wait(&users[waited++].job.task);
+        }
+        if (rc != 0) break;
+        submitted++;
+    }
+    while (waited < submitted) hash_pool_wait(&users[waited++].job.task);
+    if (rc == HASH_POOL_BUSY) fprintf(stderr, "Password hashing queue is full.\n");
+    return rc;
+}
+
+static int insert_bulk_batch(sqlite3 *db, sqlite3_stmt *stmt, bulk_user *users, int count, int *created) {
+    char encoded[PASSWORD_HASH_LEN + 1];
+    if (execute_sql(db, "BEGIN TRANSACTION;") != SQLITE_OK) return -1;
+    for (int i = 0; i < count; i++) {
+        if (!users[i].job.ok) continue;
+        encode_pbkdf2(&users[i].job, encoded);
+        sqlite3_bind_text(stmt, 1, users[i].username, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, encoded, -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            fprintf(stderr, "Failed to insert user %s: %s\n", users[i].username, sqlite3_errmsg(db));
+            sqlite3_reset(stmt);
+            execute_sql(db, "ROLLBACK;");
+            return -1;
+        }
+        users[i].created = sqlite3_changes(db) > 0;
+        sqlite3_reset(stmt);
+    }
+    if (execute_sql(db, "COMMIT;") != SQLITE_OK) return -1;
+
+    for (int i = 0; i < count; i++) {
+        if (!users[i].created) continue;
+        add_username(users[i].username);
+        (*created)++;
+    }
+    return 0;
+}
+
+/* Returns the number of accounts created (existing usernames are left alone) or -1. */
+int bulk_signup(const char *path, int iterations, int *lines_skipped) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    bulk_user *users = malloc(BULK_BATCH * sizeof(bulk_user));
+    sqlite3 *db = users ? open_database() : NULL;
+    sqlite3_stmt *stmt = NULL;
+    if (db == NULL ||
+        sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO users (username, password) VALUES (?, ?);", -1, &stmt, 0) != SQLITE_OK) {
+        if (db != NULL) fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        close_database(db);
+        free(users);
+        fclose(file);
+        return -1;
+    }
+
+    char line[256];
+    int count = 0, created = 0, skipped = 0, rc = 0, eof = 0;
+    while (rc == 0 && !eof) {
+        eof = fgets(line, sizeof(line), file) == NULL;
+        if (!eof) {
+            if (strchr(line, '\n') == NULL && !feof(file)) {
+                int ch;
+                while ((ch = fgetc(file)) != EOF && ch != '\n') {}
+                skipped++;
+                continue;
+            }
+            if (parse_bulk_line(line, &users[count]) != 0) {
+                if (line[0] != '\0' && line[0] != '#') skipped++;
+                continue;
+            }
+            if (username_taken(users[count].username)) continue;
+            users[count].created = 0;
+            count++;
+        }
+        if (count == BULK_BATCH || (eof && count > 0)) {
+            rc = hash_bulk_batch(users, count, iterations);
+            if (rc == 0) rc = insert_bulk_batch(db, stmt, users, count, &created);
+            count = 0;
+        }
+    }
+
+    sqlite3_finalize(stmt);
+    close_database(db);
+    free(users);
+    fclose(file);
+    if (lines_skipped != NULL) *lines_skipped = skipped;
+    return rc == 0 ? created : -1;
+}
+
+/* Re-hashes with the current cost after a successful login; failure leaves the old hash in place. */
+static void upgrade_password_hash(sqlite3 *db, int user_id, const char *password) {
+    char hashed_password[PASSWORD_HASH_LEN + 1];
+    if (hash_password(password, 0, hashed_password) != 0) return;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "UPDATE users SET password = ? WHERE id = ?;", -1, &stmt, 0) != SQLITE_OK) return;
+    sqlite3_bind_text(stmt, 1, hashed_password, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, user_id);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
+static int check_login(const char *username, const char *password, int *user_id) {
     sqlite3 *db = open_database();
     if (!db) return -1;
 
-    char hashed_password[65];
-    hash_password(password, hashed_password);
-
-    const char *sql = "SELECT id FROM users WHERE username = ? AND password = ?;";
+    const char *sql = "SELECT id, password FROM users WHERE username = ?;";
     sqlite3_stmt *stmt;
 
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
@@ -65,19 +349,250 @@ int login(const char *username, const char *password, int *user_id) {
     }
 
     sqlite3_bind_text(stmt, 1, username, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, hashed_password, -1, SQLITE_TRANSIENT);
 
-    int rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW) {
-        *user_id = sqlite3_column_int(stmt, 0);
+    int id = 0, match = 0, needs_upgrade = 0;
+    char stored[PASSWORD_HASH_LEN + 1] = "";
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        id = sqlite3_column_int(stmt, 0);
+        snprintf(stored, sizeof(stored), "%s", (const char *)sqlite3_column_text(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+
+    if (stored[0] != '\0') {
+        match = verify_password(password, stored, &needs_upgrade);
+    } else {
+        /* no such user: hash anyway at the current cost, so the time taken doesn't tell which names exist */
+        char dummy[PASSWORD_HASH_LEN + 1];
+        snprintf(dummy, sizeof(dummy), PBKDF2_PREFIX "%d$%0*d$%0*d", password_cost(), SALT_BYTES * 2, 0,
+                 SHA256_DIGEST_LENGTH * 2, 0);
+        match = verify_password(password, dummy, &needs_upgrade) == AUTH_BUSY ? AUTH_BUSY : 0;
+    }
+    if (match == AUTH_BUSY) {
+        printf("%sServer busy, please try again.%s\n", RED, RESET_COLOR);
+        close_database(db);
+        return AUTH_BUSY;
+    }
+    if (match == 1) {
+        if (needs_upgrade) upgrade_password_hash(db, id, password);
+        *user_id = id;
         printf("%sLogin successful!%s\n", GREEN, RESET_COLOR);
-        sqlite3_finalize(stmt);
         close_database(db);
         return 0;
     } else {
         printf("%sInvalid username or password.%s\n", RED, RESET_COLOR);
-        sqlite3_finalize(stmt);
         close_database(db);
         return -1;
     }
 }
+
+int login(const char *username, const char *password, int *user_id) {
+    uint64_t start = latency_now();
+    int rc = check_login(username, password, user_id);
+    latency_record(LAT_AUTH_LOGIN, start);
+    return rc;
+}
+
+/*
+ * Sessions: login() is paid once, then the opaque token handed out by
+ * create_session() stands in for the user. Only the SHA-256 of each token is
+ * kept (in memory, and in the optional session file), in an open-addressing
+ * table keyed by that digest, so validation is one hash and one probe and
+ * never touches the users table or the password hash.
+ */
+#define DEFAULT_SESSION_TTL (30 * 60)
+
+typedef enum { SLOT_EMPTY, SLOT_LIVE, SLOT_REMOVED } slot_state;
+
+typedef struct {
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    slot_state state;
+    int user_id;
+    time_t expires;
+} session_slot;
+
+static pthread_mutex_t session_lock = PTHREAD_MUTEX_INITIALIZER;
+static session_slot *session_slots;
+static size_t session_capacity;
+static size_t session_used;     /* live and removed slots */
+static int session_ttl = DEFAULT_SESSION_TTL;
+static char session_file[256];
+
+static size_t slot_index(const unsigned char *key) {
+    uint64_t h;
+    memcpy(&h, key, sizeof(h));
+    return (size_t)h & (session_capacity - 1);
+}
+
+static session_slot *find_session(const unsigned char *key) {
+    if (session_capacity == 0) return NULL;
+    for (size_t i = slot_index(key); session_slots[i].state != SLOT_EMPTY; i = (i + 1) & (session_capacity - 1)) {
+        if (session_slots[i].state == SLOT_LIVE && memcmp(session_slots[i].key, key, SHA256_DIGEST_LENGTH) == 0) {
+            return &session_slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void place_session(const unsigned char *key, int user_id, time_t expires) {
+    size_t i = slot_index(key);
+    while (session_slots[i].state == SLOT_LIVE) i = (i + 1) & (session_capacity - 1);
+    if (session_slots[i].state == SLOT_EMPTY) session_used++;
+    memcpy(session_slots[i].key, key, SHA256_DIGEST_LENGTH);
+    session_slots[i].state = SLOT_LIVE;
+    session_slots[i].user_id = user_id;
+    session_slots[i].expires = expires;
+}
+
+/* Rebuilds the table without removed or expired sessions, with room to grow. */
+static int rebuild_sessions(void) {
+    session_slot *old = session_slots;
+    size_t old_capacity = session_capacity, live = 0;
+    time_t now = time(NULL);
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].state == SLOT_LIVE && old[i].expires > now) live++;
+    }
+
+    size_t capacity = 64;
+    while (capacity < live * 4) capacity *= 2;
+    session_slot *slots = calloc(capacity, sizeof(session_slot));
+    if (slots == NULL) return -1;
+
+    session_slots = slots;
+    session_capacity = capacity;
+    session_used = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].state == SLOT_LIVE && old[i].expires > now) {
+            place_session(old[i].key, old[i].user_id, old[i].expires);
+        }
+    }
+    free(old);
+    return 0;
+}
+
+static int insert_session(const unsigned char *key, int user_id, time_t expires) {
+    if ((session_used + 1) * 2 > session_capacity && rebuild_sessions() != 0) return -1;
+    place_session(key, user_id, expires);
+    return 0;
+}
+
+/* Token text to table key; fails on anything that is not a well-formed token. */
+static int token_key(const char *token, unsigned char *key) {
+    unsigned char bytes[SESSION_TOKEN_BYTES];
+    if (token == NULL || hex_decode(token, bytes, SESSION_TOKEN_BYTES) != 0) return -1;
+    SHA256(bytes, sizeof(bytes), key);
+    return 0;
+}
+
+/* Rewrites the session file (if any) from the table; called with session_lock held. */
+static void save_sessions(void) {
+    if (session_file[0] == '\0') return;
+
+    char temp[sizeof(session_file) + 8];
+    snprintf(temp, sizeof(temp), "%s.tmp", session_file);
+    FILE *file = fopen(temp, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot write session file %s\n", temp);
+        return;
+    }
+
+    time_t now = time(NULL);
+    char key_hex[SHA256_DIGEST_LENGTH * 2 + 1];
+    for (size_t i = 0; i < session_capacity; i++) {
+        if (session_slots[i].state == SLOT_LIVE && session_slots[i].expires > now) {
+            hex_encode(session_slots[i].key, SHA256_DIGEST_LENGTH, key_hex);
+            fprintf(file, "%s %d %lld\n", key_hex, session_slots[i].user_id, (long long)session_slots[i].expires);
+        }
+    }
+    if (fclose(file) != 0 || rename(temp, session_file) != 0) {
+        fprintf(stderr, "Cannot write session file %s\n", session_file);
+        remove(temp);
+    }
+}
+
+static void load_sessions(void) {
+    FILE *file = fopen(session_file, "r");
+    if (file == NULL) return;
+
+    char key_hex[SHA256_DIGEST_LENGTH * 2 + 1];
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    int user_id;
+    long long expires;
+    time_t now = time(NULL);
+    while (fscanf(file, "%64s %d %lld", key_hex, &user_id, &expires) == 3) {
+        if (hex_decode(key_hex, key, SHA256_DIGEST_LENGTH) == 0 && expires > now) {
+            insert_session(key, user_id, (time_t)expires);
+        }
+    }
+    fclose(file);
+}
+
+/* Reads STOCKSIM_SESSION_TTL (seconds) and STOCKSIM_SESSION_FILE, and loads saved sessions. */
+void init_sessions(void) {
+    const char *ttl = getenv("STOCKSIM_SESSION_TTL");
+    if (ttl != NULL && atoi(ttl) > 0) set_session_ttl(atoi(ttl));
+
+    const char *path = getenv("STOCKSIM_SESSION_FILE");
+    if (path != NULL && path[0] != '\0') enable_session_persistence(path);
+}
+
+void set_session_ttl(int seconds) {
+    pthread_mutex_lock(&session_lock);
+    session_ttl = seconds > 0 ? seconds : DEFAULT_SESSION_TTL;
+    pthread_mutex_unlock(&session_lock);
+}
+
+void enable_session_persistence(const char *path) {
+    pthread_mutex_lock(&session_lock);
+    snprintf(session_file, sizeof(session_file), "%s", path);
+    load_sessions();
+    pthread_mutex_unlock(&session_lock);
+}
+
+int create_session(int user_id, char *token) {
+    unsigned char bytes[SESSION_TOKEN_BYTES];
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+        fprintf(stderr, "Failed to generate session token.\n");
+        return -1;
+    }
+    SHA256(bytes, sizeof(bytes), key);
+
+    pthread_mutex_lock(&session_lock);
+    int rc = insert_session(key, user_id, time(NULL) + session_ttl);
+    if (rc == 0) save_sessions();
+    pthread_mutex_unlock(&session_lock);
+
+    if (rc != 0) return -1;
+    hex_encode(bytes, sizeof(bytes), token);
+    return 0;
+}
+
+int validate_session(const char *token, int *user_id) {
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    if (token_key(token, key) != 0) return -1;
+
+    pthread_mutex_lock(&session_lock);
+    session_slot *slot = find_session(key);
+    int rc = -1;
+    if (slot != NULL && slot->expires > time(NULL)) {
+        *user_id = slot->user_id;
+        rc = 0;
+    } else if (slot != NULL) {
+        slot->state = SLOT_REMOVED;
+    }
+    pthread_mutex_unlock(&session_lock);
+    return rc;
+}
+
+void end_session(const char *token) {
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    if (token_key(token, key) != 0) return;
+
+    pthread_mutex_lock(&session_lock);
+    session_slot *slot = find_session(key);
+    if (slot != NULL) {
+        slot->state = SLOT_REMOVED;
+        save_sessions();
+    }
+    pthread_mutex_unlock(&session_lock);
+}
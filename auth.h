@@ -1,7 +1,35 @@
 #ifndef AUTH_H
 #define AUTH_H
 
+/* Returned by signup() and login() when the password hashing queue is full. */
+#define AUTH_BUSY -2
+/* Returned by signup() when the username already exists. */
+#define AUTH_TAKEN -3
+
 int signup(const char *username, const char *password);
 int login(const char *username, const char *password, int *user_id);
 
+/* Creates the accounts listed as "username,password" lines in path, hashing with the given
+ * PBKDF2 iterations (<= 0: the current cost). Returns how many were created, or -1. */
+int bulk_signup(const char *path, int iterations, int *lines_skipped);
+
+/* "pbkdf2-sha256$<iterations>$<salt hex>$<key hex>" fits in PASSWORD_HASH_LEN characters. */
+#define PASSWORD_HASH_LEN 127
+
+void set_password_cost(int iterations);
+int password_cost(void);
+int hash_password(const char *password, int iterations, char *encoded);
+int verify_password(const char *password, const char *encoded, int *needs_upgrade);
+
+/* Session tokens are SESSION_TOKEN_LEN hex characters (plus NUL) of randomness. */
+#define SESSION_TOKEN_BYTES 32
+#define SESSION_TOKEN_LEN (SESSION_TOKEN_BYTES * 2)
+
+void init_sessions(void);
+void set_session_ttl(int seconds);
+void enable_session_persistence(const char *path);
+int create_session(int user_id, char *token);
+int validate_session(const char *token, int *user_id);
+void end_session(const char *token);
+
 #endif 
@@ -0,0 +1,163 @@
+#include "backtest.h"
+#include "trade.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+void describe_strategy(const strategy *s, char *buffer, size_t size) {
+    switch (s->kind) {
+        case STRATEGY_BUY_AND_HOLD:
+            snprintf(buffer, size, "buy-and-hold");
+            break;
+        case STRATEGY_SMA_CROSSOVER:
+            snprintf(buffer, size, "sma(%d/%d)", s->fast_window, s->slow_window);
+            break;
+        case STRATEGY_MEAN_REVERSION:
+            snprintf(buffer, size, "meanrev(%d,%.1f)", s->slow_window, s->threshold);
+            break;
+    }
+}
+
+/* Returns 1 to hold a long position, 0 to be flat and -1 to keep whatever is held. */
+static int target_position(const strategy *s, const money_t *close, size_t i,
+                           money_t *fast_sum, money_t *slow_sum, double *sum, double *sum_sq) {
+    switch (s->kind) {
+        case STRATEGY_BUY_AND_HOLD:
+            return 1;
+
+        case STRATEGY_SMA_CROSSOVER:
+            *fast_sum += close[i];
+            *slow_sum += close[i];
+            if (i >= (size_t)s->fast_window) *fast_sum -= close[i - s->fast_window];
+            if (i >= (size_t)s->slow_window) *slow_sum -= close[i - s->slow_window];
+            if (i + 1 < (size_t)s->slow_window) return -1;
+            return (*fast_sum * s->slow_window > *slow_sum * s->fast_window) ? 1 : 0;
+
+        case STRATEGY_MEAN_REVERSION: {
+            double x = money_to_double(close[i]);
+            *sum += x;
+            *sum_sq += x * x;
+            if (i >= (size_t)s->slow_window) {
+                double old = money_to_double(close[i - s->slow_window]);
+                *sum -= old;
+                *sum_sq -= old * old;
+            }
+            if (i + 1 < (size_t)s->slow_window) return -1;
+            double mean = *sum / s->slow_window;
+            double variance = *sum_sq / s->slow_window - mean * mean;
+            if (variance <= 0.0) return -1;
+            double z = (x - mean) / sqrt(variance);
+            if (z < -s->threshold) return 1;
+            if (z > 0.0) return 0;
+            return -1;
+        }
+    }
+    return -1;
+}
+
+void run_backtest(backtest_job *job) {
+    const money_t *close = job->bars.close;
+    money_t cash = job->starting_cash;
+    holding position = { 0, 0 };
+    money_t peak = cash;
+    double max_drawdown = 0.0;
+    money_t fast_sum = 0, slow_sum = 0;
+    double sum = 0.0, sum_sq = 0.0;
+
+    job->trades = 0;
+    job->rejected_orders = 0;
+
+    for (size_t i = 0; i < job->bars.count; i++) {
+        money_t price = close[i];
+        int target = target_position(&job->strategy, close, i, &fast_sum, &slow_sum, &sum, &sum_sq);
+
+        if (target == 1 && position.quantity == 0 && price > 0) {
+            money_t affordable = cash / price;
+            int quantity = affordable > INT_MAX ? INT_MAX : (int)affordable;
+            money_t cost;
+            if (quantity > 0 && check_buy(cash, quantity, price, &cost) == TRADE_OK) {
+                cash -= cost;
+                apply_buy(&position, quantity, price);
+                job->trades++;
+            } else {
+                job->rejected_orders++;
+            }
+        } else if (target == 0 && position.quantity > 0) {
+            money_t revenue;
+            if (check_sell(position.quantity, position.quantity, price, &revenue) == TRADE_OK) {
+                cash += revenue;
+                apply_sell(&position, position.quantity);
+                job->trades++;
+            } else {
+                job->rejected_orders++;
+            }
+        }
+
+        money_t equity = cash + price * position.quantity;
+        if (equity > peak) peak = equity;
+        if (peak > 0) {
+            double drawdown = (double)(peak - equity) / (double)peak;
+            if (drawdown > max_drawdown) max_drawdown = drawdown;
+        }
+    }
+
+    money_t last = job->bars.count > 0 ? close[job->bars.count - 1] : 0;
+    job->final_equity = cash + last * position.quantity;
+    job->profit_loss = job->final_equity - job->starting_cash;
+    job->max_drawdown = max_drawdown;
+}
+
+typedef struct {
+    backtest_job *jobs;
+    size_t count;
+    size_t next;
+} job_queue;
+
+static void *backtest_worker(void *arg) {
+    job_queue *queue = arg;
+    for (;;) {
+        size_t index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+        if (index >= queue->count) break;
+        run_backtest(&queue->jobs[index]);
+    }
+    return NULL;
+}
+
+int run_backtests(backtest_job *jobs, size_t count, int threads, backtest_summary *summary) {
+    job_queue queue = { jobs, count, 0 };
+    if (threads < 1) threads = 1;
+    if ((size_t)threads > count) threads = count > 0 ? (int)count : 1;
+
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    if (workers == NULL) return -1;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, backtest_worker, &queue) != 0) break;
+    }
+    if (started == 0) {
+        backtest_worker(&queue);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(workers);
+
+    summary->jobs = count;
+    summary->trades = 0;
+    summary->bars = 0;
+    for (size_t i = 0; i < count; i++) {
+        summary->trades += jobs[i].trades;
+        summary->bars += (long)jobs[i].bars.count;
+    }
+    summary->seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    return 0;
+}
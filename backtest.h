@@ -0,0 +1,46 @@
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "money.h"
+#include "timeseries.h"
+
+typedef enum {
+    STRATEGY_BUY_AND_HOLD,
+    STRATEGY_SMA_CROSSOVER,
+    STRATEGY_MEAN_REVERSION
+} strategy_kind;
+
+typedef struct {
+    strategy_kind kind;
+    int fast_window;     /* SMA crossover: fast average length */
+    int slow_window;     /* SMA crossover: slow average; mean reversion: lookback */
+    double threshold;    /* mean reversion: buy when close is this many std devs below the mean */
+} strategy;
+
+typedef struct {
+    const char *symbol;
+    candle_range bars;
+    strategy strategy;
+    money_t starting_cash;
+
+    money_t final_equity;
+    money_t profit_loss;
+    double max_drawdown;    /* fraction of peak equity, 0..1 */
+    long trades;
+    int rejected_orders;
+} backtest_job;
+
+typedef struct {
+    size_t jobs;
+    long trades;
+    long bars;
+    double seconds;
+} backtest_summary;
+
+void describe_strategy(const strategy *s, char *buffer, size_t size);
+void run_backtest(backtest_job *job);
+int run_backtests(backtest_job *jobs, size_t count, int threads, backtest_summary *summary);
+
+#endif
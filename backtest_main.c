@@ -0,0 +1,129 @@
+// backtest_main.c
+#include "backtest.h"
+#include "timeseries.h"
+#include "trade.h"
+#include "api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#define RESET_COLOR "\033[0m"
+#define BOLD "\033[1m"
+#define CYAN "\033[36m"
+
+static const char *default_symbols[] = { "AAPL", "MSFT", "AMZN", "GOOGL", "NVDA" };
+
+static const strategy strategy_grid[] = {
+    { STRATEGY_BUY_AND_HOLD, 0, 0, 0.0 },
+    { STRATEGY_SMA_CROSSOVER, 5, 20, 0.0 },
+    { STRATEGY_SMA_CROSSOVER, 10, 50, 0.0 },
+    { STRATEGY_SMA_CROSSOVER, 20, 100, 0.0 },
+    { STRATEGY_MEAN_REVERSION, 0, 10, 1.5 },
+    { STRATEGY_MEAN_REVERSION, 0, 20, 2.0 },
+    { STRATEGY_MEAN_REVERSION, 0, 50, 1.0 },
+};
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-j threads] [-r resolution] [-d days] [-n repeat] [-q] [SYMBOL...]\n", program);
+}
+
+int main(int argc, char **argv) {
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *resolution = "D";
+    int days = 730;
+    int repeat = 1;
+    int quiet = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:r:d:n:q")) != -1) {
+        switch (opt) {
+            case 'j': threads = atoi(optarg); break;
+            case 'r': resolution = optarg; break;
+            case 'd': days = atoi(optarg); break;
+            case 'n': repeat = atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (days <= 0 || repeat <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char **symbols = (const char **)argv + optind;
+    int symbol_count = argc - optind;
+    if (symbol_count == 0) {
+        symbols = default_symbols;
+        symbol_count = sizeof(default_symbols) / sizeof(default_symbols[0]);
+    }
+
+    int64_t to = (int64_t)time(NULL);
+    int64_t from = to - (int64_t)days * 86400;
+
+    candle_series *series = calloc(symbol_count, sizeof(candle_series));
+    size_t grid = sizeof(strategy_grid) / sizeof(strategy_grid[0]);
+    size_t job_count = (size_t)symbol_count * grid * repeat;
+    backtest_job *jobs = calloc(job_count, sizeof(backtest_job));
+    if (series == NULL || jobs == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    size_t n = 0;
+    for (int i = 0; i < symbol_count; i++) {
+        candle_range bars;
+        if (ingest_candles(symbols[i], resolution, from, to) != 0 ||
+            open_candle_series(symbols[i], &series[i]) != 0 ||
+            query_candle_range(&series[i], from, to, &bars) != 0) {
+            fprintf(stderr, "Skipping %s: no candle history.\n", symbols[i]);
+            continue;
+        }
+        for (int r = 0; r < repeat; r++) {
+            for (size_t s = 0; s < grid; s++) {
+                jobs[n].symbol = symbols[i];
+                jobs[n].bars = bars;
+                jobs[n].strategy = strategy_grid[s];
+                jobs[n].starting_cash = STARTING_CASH;
+                n++;
+            }
+        }
+    }
+
+    backtest_summary summary;
+    if (run_backtests(jobs, n, threads, &summary) != 0) {
+        fprintf(stderr, "Failed to start backtest workers.\n");
+        return 1;
+    }
+
+    if (!quiet) {
+        printf("\n%s=== Backtest Results ===%s\n", CYAN, RESET_COLOR);
+        printf("%s%-8s %-18s %-8s %-15s %-10s %-10s%s\n", BOLD, "Symbol", "Strategy", "Bars", "P/L", "Return", "Max DD", RESET_COLOR);
+        /* Repeats exist only to measure throughput; print the first copy of each symbol's grid. */
+        for (size_t block = 0; block < n; block += grid * repeat) {
+            for (size_t s = 0; s < grid; s++) {
+                const backtest_job *job = &jobs[block + s];
+                char name[32], pl_buf[MONEY_STR_LEN], return_buf[16], drawdown_buf[16];
+                describe_strategy(&job->strategy, name, sizeof(name));
+                snprintf(return_buf, sizeof(return_buf), "%.2f%%", 100.0 * (double)job->profit_loss / (double)job->starting_cash);
+                snprintf(drawdown_buf, sizeof(drawdown_buf), "%.2f%%", 100.0 * job->max_drawdown);
+                printf("%-8s %-18s %-8zu $%-14s %-10s %-10s\n", job->symbol, name, job->bars.count,
+                       money_format(job->profit_loss, pl_buf), return_buf, drawdown_buf);
+            }
+        }
+    }
+
+    printf("\nJobs: %zu  Threads: %d  Bars: %ld  Trades: %ld\n", summary.jobs, threads, summary.bars, summary.trades);
+    printf("Elapsed: %.3f s  Throughput: %.0f trades/s, %.0f bars/s\n", summary.seconds,
+           summary.seconds > 0 ? summary.trades / summary.seconds : 0.0,
+           summary.seconds > 0 ? summary.bars / summary.seconds : 0.0);
+
+    for (int i = 0; i < symbol_count; i++) {
+        close_candle_series(&series[i]);
+    }
+    free(series);
+    free(jobs);
+    return 0;
+}
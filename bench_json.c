@@ -0,0 +1,1048 @@
+// bench_json.c
+#include "cJSON.h"
+#include "finnhub_decoders.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/*
+ * cJSON over Finnhub-shaped fixtures (one quote, 500 candles, 30,000 symbols,
+ * 200 news items). Parse + free cost: cJSON_Parse followed by cJSON_Delete,
+ * against cJSON_ParseInArena followed by one cJSON_ResetArena,
+ * cJSON_ParseInSitu on a copy of the text, cJSON_ScanPath pulling one
+ * field out without building a tree, and the push parser fed in chunks; then
+ * cJSON_Minify, cJSON_PrintUnformatted, member lookups and the typed decoders.
+ * Allocations are counted through cJSON_InitHooks. Every scanning run is repeated for
+ * each byte scanner the CPU supports, after checking on a fuzzed corpus that
+ * the scalar and SIMD scanners parse, scan and minify exactly like the
+ * original byte-at-a-time loops (and
+ * that streaming in random chunks matches a whole-document parse), that
+ * parsed numbers are bit-identical to strtod, that printed doubles read back
+ * exactly, that indexed member lookups find the same member as a linear scan,
+ * and that the generated typed decoders agree with walking a cJSON tree.
+ * `make bench-json` runs it with --csv for machine-readable rows.
+ */
+static size_t allocations;
+
+static void *counting_malloc(size_t size) {
+    allocations++;
+    return malloc(size);
+}
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} text_buffer;
+
+__attribute__((format(printf, 2, 3)))
+static void append_text(text_buffer *buffer, const char *format, ...) {
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+        va_end(args);
+        if (written >= 0 && (size_t)written < buffer->capacity - buffer->length) {
+            buffer->length += (size_t)written;
+            return;
+        }
+        buffer->capacity = buffer->capacity * 2 + (size_t)written + 1;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (buffer->data == NULL) {
+            fprintf(stderr, "Out of memory.\n");
+            exit(1);
+        }
+    }
+}
+
+static char *quote_fixture(void) {
+    text_buffer out = { malloc(256), 0, 256 };
+    append_text(&out, "{\"c\":189.84,\"d\":1.29,\"dp\":0.6842,\"h\":190.32,\"l\":188.19,\"o\":188.5,\"pc\":188.55,\"t\":1717185600}");
+    return out.data;
+}
+
+static char *symbols_fixture(int count) {
+    text_buffer out = { malloc(4096), 0, 4096 };
+    append_text(&out, "[");
+    for (int i = 0; i < count; i++) {
+        append_text(&out, "%s{\"currency\":\"USD\",\"description\":\"COMPANY %d INC\",\"displaySymbol\":\"S%05d\","
+                    "\"figi\":\"BBG%09d\",\"isin\":null,\"mic\":\"XNAS\",\"shareClassFIGI\":\"\",\"symbol\":\"S%05d\","
+                    "\"symbol2\":\"\",\"type\":\"Common Stock\"}", i ? "," : "", i, i, i, i);
+    }
+    append_text(&out, "]");
+    return out.data;
+}
+
+/* Shaped like /stock/metric: one wide object of per-symbol fundamentals. */
+static char *metric_fixture(int count) {
+    static const char *stems[] = { "52Week", "10DayAverage", "3MonthAverage", "beta", "bookValue", "cashFlow",
+                                   "currentRatio", "dividendYield", "ebitd", "epsGrowth", "grossMargin", "netMargin" };
+    text_buffer out = { malloc(4096), 0, 4096 };
+    append_text(&out, "{\"metric\":{");
+    for (int i = 0; i < count; i++) {
+        append_text(&out, "%s\"%s%dAnnual\":%.4f", i ? "," : "", stems[i % 12], i, 0.5 + (double)((i * 7919) % 10000) / 100.0);
+    }
+    append_text(&out, "},\"metricType\":\"all\",\"symbol\":\"AAPL\"}");
+    return out.data;
+}
+
+static char *candles_fixture(int count) {
+    static const char *columns = "tohlcv";
+    text_buffer out = { malloc(4096), 0, 4096 };
+    append_text(&out, "{");
+    for (const char *column = columns; *column; column++) {
+        append_text(&out, "\"%c\":[", *column);
+        for (int i = 0; i < count; i++) {
+            if (*column == 't') {
+                append_text(&out, "%s%d", i ? "," : "", 1600000000 + i * 86400);
+            } else if (*column == 'v') {
+                append_text(&out, "%s%d", i ? "," : "", 50000000 + (i * 7919) % 1000000);
+            } else {
+                append_text(&out, "%s%.2f", i ? "," : "", 150.0 + (double)((i * 37) % 2000) / 100.0);
+            }
+        }
+        append_text(&out, "],");
+    }
+    append_text(&out, "\"s\":\"ok\"}");
+    return out.data;
+}
+
+static char *news_fixture(int count) {
+    text_buffer out = { malloc(4096), 0, 4096 };
+    append_text(&out, "[");
+    for (int i = 0; i < count; i++) {
+        append_text(&out, "%s{\"category\":\"company\",\"datetime\":%d,\"headline\":\"Company %d shares climb as \\\"guidance\\\" "
+                    "is raised\",\"id\":%d,\"image\":\"https://static.example.com/images/%d.jpg\",\"related\":\"S%05d\","
+                    "\"source\":\"Newswire\",\"summary\":\"Shares of the company rose %d.%d%% after it reported quarterly "
+                    "revenue ahead of analyst estimates and lifted its full-year outlook. The company\\u2019s chief executive "
+                    "said demand stayed strong across regions.\",\"url\":\"https://news.example.com/article/%d\"}",
+                    i ? "," : "", 1717000000 + i * 600, i, 120000000 + i, i, i % 3000, i % 9, i % 10, i);
+    }
+    append_text(&out, "]");
+    return out.data;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Each measurement parses about BENCH_JSON_MB megabytes (default 64). */
+static int iterations_for(size_t length) {
+    const char *env = getenv("BENCH_JSON_MB");
+    size_t target = (env != NULL && atoi(env) > 0 ? (size_t)atoi(env) : 64u) * 1024 * 1024;
+    size_t n = target / (length ? length : 1);
+    return n < 20 ? 20 : (n > 2000000 ? 2000000 : (int)n);
+}
+
+static const char *scanner;
+static int csv;
+
+static void report(const char *fixture, const char *mode, size_t length, int iterations, double seconds, size_t allocs) {
+    double ns = seconds * 1e9 / iterations;
+    double mb = (double)length * iterations / seconds / 1e6;
+    if (csv) {
+        printf("%s,%s,%s,%zu,%d,%.1f,%.2f,%.2f\n", fixture, scanner, mode, length, iterations, ns, mb,
+               (double)allocs / iterations);
+        return;
+    }
+    printf("%-8s %-7s %-6s %10zu %10d %12.0f %10.1f %12.2f\n", fixture, scanner, mode, length, iterations, ns, mb,
+           (double)allocs / iterations);
+}
+
+static cJSON_bool count_slice(const cJSON_Slice *slice, void *user_data) {
+    (void)slice;
+    (*(size_t *)user_data)++;
+    return 1;
+}
+
+static void run_fixture(const char *name, const char *json, const char *path) {
+    size_t length = strlen(json);
+    int iterations = iterations_for(length);
+
+    allocations = 0;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        cJSON *tree = cJSON_Parse(json);
+        if (tree == NULL) {
+            fprintf(stderr, "Failed to parse %s fixture.\n", name);
+            exit(1);
+        }
+        cJSON_Delete(tree);
+    }
+    report(name, "heap", length, iterations, now_seconds() - start, allocations);
+
+    unsigned char stack_buffer[4096];
+    cJSON_Arena arena;
+    cJSON_InitArena(&arena, stack_buffer, sizeof(stack_buffer), 64 * 1024);
+
+    allocations = 0;
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        cJSON *tree = cJSON_ParseInArena(&arena, json);
+        if (tree == NULL) {
+            fprintf(stderr, "Failed to parse %s fixture in arena.\n", name);
+            exit(1);
+        }
+        cJSON_ResetArena(&arena);
+    }
+    report(name, "arena", length, iterations, now_seconds() - start, allocations);
+    cJSON_FreeArena(&arena);
+
+    /* includes copying the text, since parsing in situ consumes it */
+    char *copy = malloc(length + 1);
+    allocations = 0;
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        memcpy(copy, json, length + 1);
+        cJSON *tree = cJSON_ParseInSitu(copy, length);
+        if (tree == NULL) {
+            fprintf(stderr, "Failed to parse %s fixture in situ.\n", name);
+            exit(1);
+        }
+        cJSON_Delete(tree);
+    }
+    report(name, "insitu", length, iterations, now_seconds() - start, allocations);
+    free(copy);
+
+    size_t slices = 0;
+    allocations = 0;
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        if (cJSON_ScanPath(json, length, path, count_slice, &slices) <= 0) {
+            fprintf(stderr, "Failed to scan %s fixture for %s.\n", name, path);
+            exit(1);
+        }
+    }
+    report(name, "scan", length, iterations, now_seconds() - start, allocations);
+}
+
+static cJSON_bool count_element(cJSON *element, void *user_data) {
+    (void)element;
+    (*(size_t *)user_data)++;
+    return 1;
+}
+
+/* Push parsing in 16 KiB chunks, the size curl typically hands to a write callback. */
+static void run_stream(const char *name, const char *json) {
+    size_t length = strlen(json);
+    int iterations = iterations_for(length);
+
+    size_t elements = 0;
+    allocations = 0;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        cJSON_Stream *stream = cJSON_CreateStream(count_element, &elements);
+        for (size_t at = 0; at < length; at += 16384) {
+            cJSON_StreamFeed(stream, json + at, length - at < 16384 ? length - at : 16384);
+        }
+        if (cJSON_StreamFinish(stream) != 0) {
+            fprintf(stderr, "Failed to stream %s fixture.\n", name);
+            exit(1);
+        }
+        cJSON_DeleteStream(stream);
+    }
+    report(name, "stream", length, iterations, now_seconds() - start, allocations);
+}
+
+static void run_minify(const char *name, const char *json) {
+    size_t length = strlen(json);
+    int iterations = iterations_for(length);
+    char *copy = malloc(length + 1);
+    if (copy == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+
+    /* includes restoring the input with memcpy each time */
+    allocations = 0;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        memcpy(copy, json, length + 1);
+        cJSON_Minify(copy);
+    }
+    report(name, "minify", length, iterations, now_seconds() - start, allocations);
+    free(copy);
+}
+
+/* Looks up every member of object (and a missing name) `rounds` times. */
+static void run_lookups(const char *name, const char *mode, const cJSON *object, int rounds) {
+    const cJSON *member;
+    size_t lookups = 0, found = 0;
+    double start = now_seconds();
+    for (int r = 0; r < rounds; r++) {
+        cJSON_ArrayForEach(member, object) {
+            found += cJSON_GetObjectItem(object, member->string) != NULL;
+            lookups++;
+        }
+        found += cJSON_GetObjectItem(object, "missingMember") != NULL;
+        lookups++;
+    }
+    if (found != lookups - (size_t)rounds) {
+        fprintf(stderr, "Lookup found %zu of %zu members.\n", found, lookups - (size_t)rounds);
+        exit(1);
+    }
+    allocations = 0;
+    report(name, mode, 0, (int)lookups, now_seconds() - start, allocations);
+}
+
+static uint64_t fuzz_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t fuzz_next(void) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 7;
+    fuzz_state ^= fuzz_state << 17;
+    return fuzz_state;
+}
+
+/* Copies seed with a few bytes replaced, inserted or cut, favouring the bytes the scanners look for. */
+static char *mutate(const char *seed) {
+    static const char interesting[] = "\"\\ \t\r\n/{}[],:\x01\x1f\x7f\x80\xff" "0u*";
+    size_t length = strlen(seed);
+    char *out = malloc(length * 2 + 64);
+    memcpy(out, seed, length + 1);
+    int edits = 1 + (int)(fuzz_next() % 4);
+    for (int e = 0; e < edits && length > 0; e++) {
+        size_t at = (size_t)(fuzz_next() % length);
+        char c = interesting[fuzz_next() % (sizeof(interesting) - 1)];
+        switch (fuzz_next() % 4) {
+            case 0:
+                out[at] = c;
+                break;
+            case 1:
+                memmove(out + at + 1, out + at, length - at + 1);
+                out[at] = c;
+                length++;
+                break;
+            case 2:
+                memmove(out + at, out + at + 1, length - at);
+                length--;
+                break;
+            default:
+                out[at] = '\0';
+                length = at;
+                break;
+        }
+    }
+    return out;
+}
+
+static cJSON_bool concat_slice(const cJSON_Slice *slice, void *user_data) {
+    text_buffer *out = user_data;
+    append_text(out, "%d:%.*s|", slice->type, (int)slice->length, slice->start);
+    return 1;
+}
+
+static cJSON_bool concat_element(cJSON *element, void *user_data) {
+    text_buffer *out = user_data;
+    char *printed = cJSON_PrintUnformatted(element);
+    append_text(out, "%s|", printed ? printed : "<fail>");
+    free(printed);
+    return 1;
+}
+
+/* Feeds json to the push parser in random chunks; it must agree with a strict parse of the whole text. */
+static void check_stream(const char *json, size_t length) {
+    text_buffer streamed = { calloc(1, 256), 0, 256 };
+    cJSON_Stream *stream = cJSON_CreateStream(concat_element, &streamed);
+    int status = 0;
+    for (size_t at = 0; at < length && status == 0;) {
+        size_t chunk = 1 + (size_t)(fuzz_next() % 64);
+        if (chunk > length - at) chunk = length - at;
+        status = cJSON_StreamFeed(stream, json + at, chunk);
+        at += chunk;
+    }
+    if (status == 0) status = cJSON_StreamFinish(stream);
+    cJSON_DeleteStream(stream);
+
+    text_buffer expected = { calloc(1, 256), 0, 256 };
+    cJSON *tree = cJSON_ParseWithOpts(json, NULL, 1);
+    int array = cJSON_IsArray(tree);
+    cJSON *item;
+    if (array) {
+        cJSON_ArrayForEach(item, tree) concat_element(item, &expected);
+    }
+    cJSON_Delete(tree);
+
+    if ((status == 0) != array || (array && strcmp(streamed.data, expected.data) != 0)) {
+        fprintf(stderr, "Streaming parse differs on:\n%s\n--- parse\n%s\n--- stream (%d)\n%s\n", json,
+                array ? expected.data : "<not an array>", status, streamed.data);
+        exit(1);
+    }
+    free(streamed.data);
+    free(expected.data);
+}
+
+/* Everything a scanner can influence, rendered as one string. */
+static char *fingerprint(const char *json) {
+    text_buffer out = { malloc(256), 0, 256 };
+    size_t length = strlen(json);
+
+    cJSON *tree = cJSON_ParseWithLength(json, length + 1);
+    char *printed = tree ? cJSON_PrintUnformatted(tree) : NULL;
+    append_text(&out, "parse=%s\n", printed ? printed : "<fail>");
+
+    /* in situ must build the same tree */
+    char *copy = strdup(json);
+    cJSON *in_situ = cJSON_ParseInSitu(copy, length + 1);
+    char *in_situ_printed = in_situ ? cJSON_PrintUnformatted(in_situ) : NULL;
+    if ((printed == NULL) != (in_situ_printed == NULL) || (printed && strcmp(printed, in_situ_printed) != 0)) {
+        fprintf(stderr, "In-situ parse differs on:\n%s\n--- parse\n%s\n--- in situ\n%s\n", json,
+                printed ? printed : "<fail>", in_situ_printed ? in_situ_printed : "<fail>");
+        exit(1);
+    }
+    free(in_situ_printed);
+    cJSON_Delete(in_situ);
+    free(copy);
+    free(printed);
+    cJSON_Delete(tree);
+    check_stream(json, length);
+
+    static const char *paths[] = { "c", "[*].symbol", "[*]", "[1].description" };
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        append_text(&out, "scan %s=", paths[i]);
+        append_text(&out, " %d\n", cJSON_ScanPath(json, length, paths[i], concat_slice, &out));
+    }
+
+    char *minified = malloc(length + 1);
+    memcpy(minified, json, length + 1);
+    cJSON_Minify(minified);
+    append_text(&out, "minify=%s\n", minified);
+    free(minified);
+    return out.data;
+}
+
+static int verify_scanners(const char **scanners, int scanner_count, const char **seeds, int seed_count, int mutations) {
+    int documents = 0;
+    for (int s = 0; s < seed_count; s++) {
+        for (int m = 0; m <= mutations; m++) {
+            char *json = m == 0 ? strdup(seeds[s]) : mutate(seeds[s]);
+            cJSON_UseScanner("bytewise");
+            char *expected = fingerprint(json);
+            for (int k = 0; k < scanner_count; k++) {
+                cJSON_UseScanner(scanners[k]);
+                char *actual = fingerprint(json);
+                if (strcmp(expected, actual) != 0) {
+                    fprintf(stderr, "Scanner %s disagrees with bytewise on:\n%s\n--- bytewise\n%s--- %s\n%s", scanners[k], json,
+                            expected, scanners[k], actual);
+                    return -1;
+                }
+                free(actual);
+            }
+            free(expected);
+            free(json);
+            documents++;
+        }
+    }
+    return documents;
+}
+
+/* Parses text as a JSON document and checks the double against strtod bit for bit. */
+static int check_number(const char *text) {
+    cJSON *item = cJSON_Parse(text);
+    double expected = strtod(text, NULL);
+    int ok = item != NULL && cJSON_IsNumber(item) && memcmp(&item->valuedouble, &expected, sizeof(double)) == 0;
+    if (!ok) {
+        fprintf(stderr, "Number mismatch for \"%s\": got %.17g, strtod %.17g\n", text,
+                item ? item->valuedouble : 0.0, expected);
+    }
+    cJSON_Delete(item);
+    return ok;
+}
+
+static int verify_numbers(int rounds) {
+    static const char *edges[] = {
+        "0", "-0", "0.0", "1", "-1", "9007199254740992", "9007199254740993", "9007199254740991.5",
+        "1e22", "1e23", "-1e22", "123456789e15", "123456789e16", "9007199254740991e15", "1.7976931348623157e308",
+        "2.2250738585072014e-308", "4.9e-324", "1e-400", "1e400", "0.1", "0.3", "189.84", "1717185600",
+        "18446744073709551615", "1234567890123456789", "12345678901234567890", "0.000000000000000000001",
+        "1E5", "1e+5", "1e-5", "00012.5000", "1."
+    };
+    int checked = 0;
+    char text[64];
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++, checked++) {
+        if (!check_number(edges[i])) return -1;
+    }
+
+    for (int r = 0; r < rounds; r++) {
+        uint64_t bits = fuzz_next();
+        double random_double;
+        memcpy(&random_double, &bits, sizeof(random_double));
+        if (random_double == random_double && random_double - random_double == 0.0) {
+            static const char *formats[] = { "%.17g", "%.15g", "%.6g", "%.3e" };
+            for (int f = 0; f < 4; f++, checked++) {
+                snprintf(text, sizeof(text), formats[f], random_double);
+                if (!check_number(text)) return -1;
+            }
+        }
+
+        /* prices and quantities as Finnhub sends them */
+        int decimals = (int)(fuzz_next() % 7);
+        snprintf(text, sizeof(text), "%llu.%0*llu", (unsigned long long)(fuzz_next() % 1000000), decimals,
+                 (unsigned long long)(fuzz_next() % 1000000) % (decimals ? (unsigned long long)1 << (decimals * 3) : 1));
+        if (decimals == 0) text[strlen(text) - 1] = '\0';
+        checked++;
+        if (!check_number(text)) return -1;
+
+        /* up to 19 digits around the fast path's exponent limits */
+        unsigned long long mantissa = fuzz_next() >> (fuzz_next() % 64);
+        snprintf(text, sizeof(text), "%llue%d", mantissa, (int)(fuzz_next() % 80) - 40);
+        checked++;
+        if (!check_number(text)) return -1;
+    }
+    return checked;
+}
+
+static double random_finite_double(void) {
+    for (;;) {
+        uint64_t bits = fuzz_next();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        if (value == value && value - value == 0.0) return value;
+    }
+}
+
+/* Digits of the mantissa without leading or trailing zeros. */
+static int significant_digits(const char *text) {
+    const char *end = text + strcspn(text, "eE");
+    int count = 0, zeros = 0, started = 0;
+    for (const char *c = text; c < end; c++) {
+        if (*c < '0' || *c > '9') continue;
+        if (*c == '0') {
+            if (started) zeros++;
+            continue;
+        }
+        started = 1;
+        count += zeros + 1;
+        zeros = 0;
+    }
+    return count;
+}
+
+/* Prints random doubles and prices through cJSON and reads them back with strtod. */
+static int verify_printing(int rounds, int *longer_than_shortest) {
+    *longer_than_shortest = 0;
+    for (int r = 0; r < rounds; r++) {
+        double value = (r & 1) ? random_finite_double()
+                               : (double)(fuzz_next() % 100000000) / 100.0 * ((r & 2) ? 1e-3 : 1.0);
+        cJSON *number = cJSON_CreateNumber(value);
+        char *printed = cJSON_PrintUnformatted(number);
+        double back = strtod(printed, NULL);
+        if (memcmp(&back, &value, sizeof(double)) != 0) {
+            fprintf(stderr, "%.17g printed as %s, which reads back as %.17g\n", value, printed, back);
+            return -1;
+        }
+
+        /* compare the digit count with the shortest %.*g that round-trips */
+        char shortest[32];
+        int precision = 1;
+        for (; precision <= 17; precision++) {
+            snprintf(shortest, sizeof(shortest), "%.*g", precision, value);
+            if (strtod(shortest, NULL) == value) break;
+        }
+        if (significant_digits(printed) > significant_digits(shortest)) (*longer_than_shortest)++;
+
+        free(printed);
+        cJSON_Delete(number);
+    }
+    return rounds;
+}
+
+/* What print_number used to do: %1.15g, check with sscanf, else %1.17g. */
+static int legacy_format(double value, char *buffer) {
+    double test = 0.0;
+    int length = sprintf(buffer, "%1.15g", value);
+    if (sscanf(buffer, "%lg", &test) != 1 || test != value) {
+        length = sprintf(buffer, "%1.17g", value);
+    }
+    return length;
+}
+
+static void run_print(const char *name, const char *json) {
+    cJSON *tree = cJSON_Parse(json);
+    char *printed = cJSON_PrintUnformatted(tree);
+    size_t length = strlen(printed);
+    free(printed);
+
+    int iterations = iterations_for(length);
+    allocations = 0;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        free(cJSON_PrintUnformatted(tree));
+    }
+    report(name, "print", length, iterations, now_seconds() - start, allocations);
+    cJSON_Delete(tree);
+}
+
+/* Looks every member up by name, in the top-level object or in each element of a top-level array. */
+static void run_member_lookups(const char *name, const char *json) {
+    cJSON *tree = cJSON_Parse(json);
+    cJSON *single[] = { tree, NULL };
+    size_t objects = cJSON_IsArray(tree) ? (size_t)cJSON_GetArraySize(tree) : 1;
+    cJSON **list = cJSON_IsArray(tree) ? malloc(objects * sizeof(cJSON *)) : single;
+    size_t members = 0;
+    if (cJSON_IsArray(tree)) {
+        size_t i = 0;
+        cJSON *element;
+        cJSON_ArrayForEach(element, tree) list[i++] = element;
+    }
+    for (size_t i = 0; i < objects; i++) members += (size_t)cJSON_GetArraySize(list[i]);
+
+    int rounds = (int)(1000000 / (members ? members : 1)) + 1;
+    size_t lookups = 0, found = 0;
+    allocations = 0;
+    double start = now_seconds();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < objects; i++) {
+            const cJSON *member;
+            cJSON_ArrayForEach(member, list[i]) {
+                found += cJSON_GetObjectItem(list[i], member->string) == member;
+                lookups++;
+            }
+        }
+    }
+    if (found != lookups) {
+        fprintf(stderr, "Lookup found %zu of %zu members in %s.\n", found, lookups, name);
+        exit(1);
+    }
+    report(name, "lookup", 0, (int)lookups, now_seconds() - start, allocations);
+
+    if (list != single) free(list);
+    cJSON_Delete(tree);
+}
+
+static void run_printing(int count) {
+    double *prices = malloc((size_t)count * sizeof(double));
+    cJSON *array = cJSON_CreateArray();
+    for (int i = 0; i < count; i++) {
+        prices[i] = (double)(fuzz_next() % 10000000) / 100.0 + 0.01;
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(prices[i]));
+    }
+    char *printed = cJSON_PrintUnformatted(array);
+    size_t length = strlen(printed);
+    free(printed);
+
+    int iterations = iterations_for(length);
+    allocations = 0;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        free(cJSON_PrintUnformatted(array));
+    }
+    report("prices", "print", length, iterations, now_seconds() - start, allocations);
+
+    char buffer[32];
+    size_t sink = 0;
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        for (int p = 0; p < count; p++) sink += (size_t)legacy_format(prices[p], buffer);
+    }
+    report("prices", "legacy", sink / (size_t)iterations + (size_t)count, iterations, now_seconds() - start, 0);
+
+    cJSON_Delete(array);
+    free(prices);
+}
+
+static const cJSON *linear_lookup(const cJSON *object, const char *name, int case_sensitive) {
+    const cJSON *member;
+    cJSON_ArrayForEach(member, object) {
+        if ((case_sensitive ? strcmp(member->string, name) : strcasecmp(member->string, name)) == 0) return member;
+    }
+    return NULL;
+}
+
+static int verify_lookups(void) {
+    text_buffer json = { malloc(4096), 0, 4096 };
+    append_text(&json, "{");
+    for (int i = 0; i < 200; i++) {
+        /* every fifth name repeats an earlier one with different case */
+        if (i % 5 == 4) {
+            append_text(&json, "\"KEY%d\":%d,", i - 2, i);
+        } else {
+            append_text(&json, "\"key%d\":%d,", i, i);
+        }
+    }
+    append_text(&json, "\"last\":0}");
+
+    cJSON *object = cJSON_Parse(json.data);
+    int checked = 0;
+    for (int i = 0; i < 220; i++) {
+        char lower[32], upper[32];
+        snprintf(lower, sizeof(lower), "key%d", i);
+        snprintf(upper, sizeof(upper), "KEY%d", i);
+        const char *names[] = { lower, upper };
+        for (int n = 0; n < 2; n++, checked += 2) {
+            if (cJSON_GetObjectItem(object, names[n]) != linear_lookup(object, names[n], 0) ||
+                cJSON_GetObjectItemCaseSensitive(object, names[n]) != linear_lookup(object, names[n], 1)) {
+                fprintf(stderr, "Indexed lookup of %s disagrees with a linear scan.\n", names[n]);
+                return -1;
+            }
+        }
+    }
+
+    /* mutations drop the index, later lookups must still see the change */
+    cJSON_AddNumberToObject(object, "added", 1);
+    cJSON_DeleteItemFromObject(object, "key0");
+    if (cJSON_GetObjectItem(object, "added") == NULL || cJSON_GetObjectItem(object, "key0") != NULL) {
+        fprintf(stderr, "Lookup after mutation returned a stale member.\n");
+        return -1;
+    }
+    cJSON_Delete(object);
+    free(json.data);
+    return checked + 2;
+}
+
+/* The generic path the typed decoders replace: build a tree, then look up and type-check every member. */
+static int number_member(const cJSON *object, const char *name, double *value) {
+    const cJSON *item = cJSON_GetObjectItem(object, name);
+    if (!cJSON_IsNumber(item)) return 0;
+    *value = item->valuedouble;
+    return 1;
+}
+
+static void string_member(const cJSON *object, const char *name, char *buffer, size_t size) {
+    const cJSON *item = cJSON_GetObjectItem(object, name);
+    if (cJSON_IsString(item)) snprintf(buffer, size, "%s", item->valuestring);
+}
+
+static int generic_quote(const char *json, finnhub_quote *quote) {
+    cJSON *tree = cJSON_Parse(json);
+    if (!cJSON_IsObject(tree)) {
+        cJSON_Delete(tree);
+        return -1;
+    }
+    double value;
+    memset(quote, 0, sizeof(*quote));
+    if (number_member(tree, "c", &value)) quote->current = money_from_double(value);
+    if (number_member(tree, "d", &value)) quote->change = money_from_double(value);
+    if (number_member(tree, "dp", &value)) quote->percent_change = value;
+    if (number_member(tree, "h", &value)) quote->high = money_from_double(value);
+    if (number_member(tree, "l", &value)) quote->low = money_from_double(value);
+    if (number_member(tree, "o", &value)) quote->open = money_from_double(value);
+    if (number_member(tree, "pc", &value)) quote->previous_close = money_from_double(value);
+    if (number_member(tree, "t", &value)) quote->timestamp = (int64_t)value;
+    cJSON_Delete(tree);
+    return 0;
+}
+
+static size_t generic_column(const cJSON *object, const char *name, int64_t **column, int money) {
+    const cJSON *array = cJSON_GetObjectItem(object, name);
+    const cJSON *item;
+    size_t n = 0;
+    *column = malloc(((size_t)cJSON_GetArraySize(array) + 1) * sizeof(int64_t));
+    cJSON_ArrayForEach(item, array) {
+        (*column)[n++] = money ? money_from_double(item->valuedouble) : (int64_t)item->valuedouble;
+    }
+    return n;
+}
+
+static int generic_candles(const char *json, finnhub_candles *candles) {
+    cJSON *tree = cJSON_Parse(json);
+    if (!cJSON_IsObject(tree)) {
+        cJSON_Delete(tree);
+        return -1;
+    }
+    memset(candles, 0, sizeof(*candles));
+    string_member(tree, "s", candles->status, sizeof(candles->status));
+    candles->timestamp_count = generic_column(tree, "t", &candles->timestamp, 0);
+    candles->open_count = generic_column(tree, "o", &candles->open, 1);
+    candles->high_count = generic_column(tree, "h", &candles->high, 1);
+    candles->low_count = generic_column(tree, "l", &candles->low, 1);
+    candles->close_count = generic_column(tree, "c", &candles->close, 1);
+    candles->volume_count = generic_column(tree, "v", &candles->volume, 0);
+    cJSON_Delete(tree);
+    return 0;
+}
+
+static int generic_symbols(const char *json, int (*each)(const finnhub_symbol *, void *), void *user) {
+    cJSON *tree = cJSON_Parse(json);
+    if (!cJSON_IsArray(tree)) {
+        cJSON_Delete(tree);
+        return -1;
+    }
+    const cJSON *element;
+    finnhub_symbol symbol;
+    int count = 0;
+    cJSON_ArrayForEach(element, tree) {
+        memset(&symbol, 0, sizeof(symbol));
+        string_member(element, "currency", symbol.currency, sizeof(symbol.currency));
+        string_member(element, "description", symbol.description, sizeof(symbol.description));
+        string_member(element, "displaySymbol", symbol.display_symbol, sizeof(symbol.display_symbol));
+        string_member(element, "figi", symbol.figi, sizeof(symbol.figi));
+        string_member(element, "mic", symbol.mic, sizeof(symbol.mic));
+        string_member(element, "symbol", symbol.symbol, sizeof(symbol.symbol));
+        string_member(element, "type", symbol.type, sizeof(symbol.type));
+        count++;
+        if (!each(&symbol, user)) break;
+    }
+    cJSON_Delete(tree);
+    return count;
+}
+
+static int generic_news(const char *json, int (*each)(const finnhub_news *, void *), void *user) {
+    cJSON *tree = cJSON_Parse(json);
+    if (!cJSON_IsArray(tree)) {
+        cJSON_Delete(tree);
+        return -1;
+    }
+    const cJSON *element;
+    finnhub_news news;
+    double value;
+    int count = 0;
+    cJSON_ArrayForEach(element, tree) {
+        memset(&news, 0, sizeof(news));
+        string_member(element, "category", news.category, sizeof(news.category));
+        if (number_member(element, "datetime", &value)) news.datetime = (int64_t)value;
+        string_member(element, "headline", news.headline, sizeof(news.headline));
+        if (number_member(element, "id", &value)) news.id = (int64_t)value;
+        string_member(element, "image", news.image, sizeof(news.image));
+        string_member(element, "related", news.related, sizeof(news.related));
+        string_member(element, "source", news.source, sizeof(news.source));
+        string_member(element, "summary", news.summary, sizeof(news.summary));
+        string_member(element, "url", news.url, sizeof(news.url));
+        count++;
+        if (!each(&news, user)) break;
+    }
+    cJSON_Delete(tree);
+    return count;
+}
+
+static void describe_quote(text_buffer *out, const finnhub_quote *q) {
+    append_text(out, "%lld %lld %.17g %lld %lld %lld %lld %lld\n", (long long)q->current, (long long)q->change,
+                q->percent_change, (long long)q->high, (long long)q->low, (long long)q->open,
+                (long long)q->previous_close, (long long)q->timestamp);
+}
+
+static void describe_candles(text_buffer *out, const finnhub_candles *c) {
+    append_text(out, "%s %zu %zu %zu %zu %zu %zu\n", c->status, c->timestamp_count, c->open_count, c->high_count,
+                c->low_count, c->close_count, c->volume_count);
+    for (size_t i = 0; i < c->timestamp_count && i < c->close_count && i < c->volume_count; i++) {
+        append_text(out, "%lld %lld %lld\n", (long long)c->timestamp[i], (long long)c->close[i], (long long)c->volume[i]);
+    }
+}
+
+static int describe_symbol(const finnhub_symbol *s, void *user) {
+    append_text(user, "%s|%s|%s|%s|%s|%s|%s\n", s->currency, s->description, s->display_symbol, s->figi, s->mic,
+                s->symbol, s->type);
+    return 1;
+}
+
+static int describe_news(const finnhub_news *n, void *user) {
+    append_text(user, "%s|%lld|%s|%lld|%s|%s|%s|%s|%s\n", n->category, (long long)n->datetime, n->headline,
+                (long long)n->id, n->image, n->related, n->source, n->summary, n->url);
+    return 1;
+}
+
+/* Renders what one path decoded, or NULL if it rejected the payload. */
+static char *describe_payload(const char *kind, const char *json, int typed) {
+    text_buffer out = { calloc(1, 256), 0, 256 };
+    size_t length = strlen(json);
+    int rc;
+    if (strcmp(kind, "quote") == 0) {
+        finnhub_quote quote;
+        rc = typed ? decode_finnhub_quote(json, length, &quote) : generic_quote(json, &quote);
+        if (rc == 0) describe_quote(&out, &quote);
+    } else if (strcmp(kind, "candles") == 0) {
+        finnhub_candles candles;
+        rc = typed ? decode_finnhub_candles(json, length, &candles) : generic_candles(json, &candles);
+        if (rc == 0) {
+            describe_candles(&out, &candles);
+            free_finnhub_candles(&candles);
+        }
+    } else if (strcmp(kind, "symbols") == 0) {
+        rc = typed ? decode_finnhub_symbol_array(json, length, describe_symbol, &out) : generic_symbols(json, describe_symbol, &out);
+    } else {
+        rc = typed ? decode_finnhub_news_array(json, length, describe_news, &out) : generic_news(json, describe_news, &out);
+    }
+    if (rc < 0) {
+        free(out.data);
+        return NULL;
+    }
+    return out.data;
+}
+
+/* Typed decoders must match the generic path on the fixtures, and on fuzzed copies that both accept. */
+static int verify_decoders(const char **kinds, const char **payloads, int count, int mutations) {
+    int checked = 0;
+    for (int k = 0; k < count; k++) {
+        for (int m = 0; m <= mutations; m++) {
+            char *json = m == 0 ? strdup(payloads[k]) : mutate(payloads[k]);
+            char *typed = describe_payload(kinds[k], json, 1);
+            char *generic = describe_payload(kinds[k], json, 0);
+            if ((m == 0 && typed == NULL) || (typed && generic && strcmp(typed, generic) != 0)) {
+                fprintf(stderr, "Typed %s decoder disagrees with cJSON on:\n%s\n--- typed\n%s--- cJSON\n%s", kinds[k], json,
+                        typed ? typed : "<fail>\n", generic ? generic : "<fail>\n");
+                return -1;
+            }
+            free(typed);
+            free(generic);
+            free(json);
+            checked++;
+        }
+    }
+    return checked;
+}
+
+static int count_symbol(const finnhub_symbol *symbol, void *user) {
+    (void)symbol;
+    (*(size_t *)user)++;
+    return 1;
+}
+
+static int count_news(const finnhub_news *news, void *user) {
+    (void)news;
+    (*(size_t *)user)++;
+    return 1;
+}
+
+/* Decoding into the structs: tree plus member lookups ("cjson") against the generated decoder ("typed"). */
+static void run_typed(const char *kind, const char *json) {
+    size_t length = strlen(json);
+    int iterations = iterations_for(length);
+
+    for (int typed = 0; typed < 2; typed++) {
+        size_t elements = 0;
+        allocations = 0;
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            int rc;
+            if (strcmp(kind, "quote") == 0) {
+                finnhub_quote quote;
+                rc = typed ? decode_finnhub_quote(json, length, &quote) : generic_quote(json, &quote);
+            } else if (strcmp(kind, "candles") == 0) {
+                finnhub_candles candles;
+                rc = typed ? decode_finnhub_candles(json, length, &candles) : generic_candles(json, &candles);
+                if (rc == 0) free_finnhub_candles(&candles);
+            } else if (strcmp(kind, "symbols") == 0) {
+                rc = typed ? decode_finnhub_symbol_array(json, length, count_symbol, &elements)
+                           : generic_symbols(json, count_symbol, &elements);
+            } else {
+                rc = typed ? decode_finnhub_news_array(json, length, count_news, &elements)
+                           : generic_news(json, count_news, &elements);
+            }
+            if (rc < 0) {
+                fprintf(stderr, "Failed to decode %s fixture.\n", kind);
+                exit(1);
+            }
+        }
+        report(kind, typed ? "typed" : "cjson", length, iterations, now_seconds() - start, allocations);
+    }
+}
+
+int main(int argc, char **argv) {
+    /* --csv: results as CSV rows on stdout, everything else on stderr */
+    csv = argc > 1 && strcmp(argv[1], "--csv") == 0;
+    FILE *notes = csv ? stderr : stdout;
+    cJSON_Hooks hooks = { counting_malloc, free };
+    cJSON_InitHooks(&hooks);
+
+    const char *default_scanner = cJSON_GetScanner();
+    const char *candidates[] = { "scalar", "sse2", "avx2" };
+    const char *scanners[3];
+    int scanner_count = 0;
+    for (int i = 0; i < 3; i++) {
+        if (cJSON_UseScanner(candidates[i])) scanners[scanner_count++] = candidates[i];
+    }
+
+    char *quote = quote_fixture();
+    char *symbols = symbols_fixture(30000);
+    char *candles = candles_fixture(500);
+    char *news = news_fixture(200);
+    char *small_symbols = symbols_fixture(3);
+    cJSON *tree = cJSON_Parse(small_symbols);
+    char *pretty_small = cJSON_Print(tree);
+    cJSON_Delete(tree);
+
+    const char *seeds[] = {
+        quote, small_symbols, pretty_small,
+        "{\"c\":\"esc \\\" \\\\ \\/ \\b\\f\\n\\r\\t \\u00e9 \\ud83d\\ude00 end of a string longer than one block\"}",
+        "[ \"a\" ,\t\r\n \"0123456789abcdef0123456789abcdef\\\\\" , /* comment */ 1 // line\n ]",
+        "\xEF\xBB\xBF[1, -2.5e3 ,\"]\\\"[\",true,null,[[]],{\"a\":[1,{}]}, \"x\" ]",
+    };
+    int documents = verify_scanners(scanners, scanner_count, seeds, sizeof(seeds) / sizeof(seeds[0]), 2000);
+    if (documents < 0) return 1;
+    fprintf(notes, "verified %d documents against the bytewise loops (default: %s)\n", documents, default_scanner);
+    int numbers = verify_numbers(200000);
+    if (numbers < 0) return 1;
+    fprintf(notes, "verified %d numbers against strtod\n", numbers);
+    int lookups = verify_lookups();
+    if (lookups < 0) return 1;
+    fprintf(notes, "verified %d indexed lookups against a linear scan\n", lookups);
+    int longer = 0;
+    int printed = verify_printing(200000, &longer);
+    if (printed < 0) return 1;
+    fprintf(notes, "verified %d printed doubles read back exactly (%d not shortest)\n", printed, longer);
+    const char *kinds[] = { "quote", "candles", "symbols", "news" };
+    const char *payloads[] = { quote, candles_fixture(20), small_symbols, news_fixture(3) };
+    int decoded = verify_decoders(kinds, payloads, 4, 2000);
+    if (decoded < 0) return 1;
+    fprintf(notes, "verified %d payloads decoded by the typed decoders against cJSON\n\n", decoded);
+    free((char *)payloads[1]);
+    free((char *)payloads[3]);
+
+    const struct {
+        const char *name;
+        char *json;
+        const char *path;
+    } fixtures[] = {
+        { "quote", quote, "c" },
+        { "candles", candles, "c[*]" },
+        { "symbols", symbols, "[*].symbol" },
+        { "news", news, "[*].headline" },
+    };
+    int fixture_count = (int)(sizeof(fixtures) / sizeof(fixtures[0]));
+    char *pretty[4];
+    for (int f = 0; f < fixture_count; f++) {
+        tree = cJSON_Parse(fixtures[f].json);
+        pretty[f] = cJSON_Print(tree);
+        cJSON_Delete(tree);
+    }
+
+    if (csv) {
+        printf("fixture,scanner,mode,bytes,iterations,ns_per_op,mb_per_s,allocs_per_op\n");
+    } else {
+        printf("%-8s %-7s %-6s %10s %10s %12s %10s %12s\n", "fixture", "scanner", "mode", "bytes", "iters", "ns/op", "MB/s", "allocs/op");
+    }
+    for (int i = 0; i < scanner_count; i++) {
+        scanner = scanners[i];
+        cJSON_UseScanner(scanner);
+        for (int f = 0; f < fixture_count; f++) {
+            run_fixture(fixtures[f].name, fixtures[f].json, fixtures[f].path);
+            if (fixtures[f].json[0] == '[') run_stream(fixtures[f].name, fixtures[f].json);
+            run_minify(fixtures[f].name, pretty[f]);
+        }
+    }
+
+    /* printing and lookups do not depend on the scanner; duplicates are never indexed */
+    scanner = "-";
+    cJSON_UseScanner(default_scanner);
+    for (int f = 0; f < fixture_count; f++) {
+        run_print(fixtures[f].name, fixtures[f].json);
+        run_member_lookups(fixtures[f].name, fixtures[f].json);
+    }
+    char *metric = metric_fixture(130);
+    cJSON *metric_tree = cJSON_Parse(metric);
+    cJSON *metric_copy = cJSON_Duplicate(metric_tree, 1);
+    run_lookups("metric", "lookup", cJSON_GetObjectItem(metric_tree, "metric"), 20000);
+    run_lookups("metric", "linear", cJSON_GetObjectItem(metric_copy, "metric"), 20000);
+    run_printing(10000);
+    for (int f = 0; f < fixture_count; f++) {
+        run_typed(fixtures[f].name, fixtures[f].json);
+    }
+    cJSON_Delete(metric_tree);
+    cJSON_Delete(metric_copy);
+    free(metric);
+
+    for (int f = 0; f < fixture_count; f++) {
+        free(fixtures[f].json);
+        free(pretty[f]);
+    }
+    free(small_symbols);
+    free(pretty_small);
+    return 0;
+}
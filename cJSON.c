@@ -45,6 +45,13 @@
 #include <ctype.h>
 #include <float.h>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CJSON_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define CJSON_X86_SIMD 0
+#endif
+
 #ifdef ENABLE_LOCALES
 #include <locale.h>
 #endif
@@ -158,6 +165,8 @@ typedef struct internal_hooks
     void *(CJSON_CDECL *allocate)(size_t size);
     void (CJSON_CDECL *deallocate)(void *pointer);
     void *(CJSON_CDECL *reallocate)(void *pointer, size_t size);
+    /* when set, parse allocations come from this arena and are never freed individually */
+    cJSON_Arena *arena;
 } internal_hooks;
 
 #if defined(_MSC_VER)
@@ -183,7 +192,153 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 /* strlen of character literals resolved at compile time */
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
-static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
+static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc, NULL };
+
+typedef struct cJSON_ArenaBlock
+{
+    struct cJSON_ArenaBlock *next;
+    size_t size;
+} cJSON_ArenaBlock;
+
+/* every allocation handed out by an arena is aligned for any cJSON member */
+typedef union
+{
+    double number;
+    void *pointer;
+    size_t size;
+} arena_alignment;
+
+#define arena_align(size) (((size) + sizeof(arena_alignment) - 1) & ~(sizeof(arena_alignment) - 1))
+#define arena_block_header arena_align(sizeof(cJSON_ArenaBlock))
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    cJSON_ArenaBlock *next = NULL;
+    cJSON_ArenaBlock *block = NULL;
+    size_t block_size = 0;
+
+    size = arena_align(size);
+    if ((arena->cursor != NULL) && ((size_t)(arena->limit - arena->cursor) >= size))
+    {
+        void *pointer = arena->cursor;
+        arena->cursor += size;
+        return pointer;
+    }
+
+    /* reuse the next heap block if it is large enough, otherwise insert a new one after the current block */
+    next = (arena->current == NULL) ? arena->blocks : arena->current->next;
+    if ((next != NULL) && (next->size >= size))
+    {
+        block = next;
+    }
+    else
+    {
+        block_size = (size > arena->block_size) ? size : arena->block_size;
+        block = (cJSON_ArenaBlock*)global_hooks.allocate(arena_block_header + block_size);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+        block->size = block_size;
+        block->next = next;
+        if (arena->current == NULL)
+        {
+            arena->blocks = block;
+        }
+        else
+        {
+            arena->current->next = block;
+        }
+    }
+
+    arena->current = block;
+    arena->cursor = (unsigned char*)block + arena_block_header + size;
+    arena->limit = (unsigned char*)block + arena_block_header + block->size;
+    return (unsigned char*)block + arena_block_header;
+}
+
+static void *hooks_allocate(const internal_hooks * const hooks, size_t size)
+{
+    if (hooks->arena != NULL)
+    {
+        return arena_allocate(hooks->arena, size);
+    }
+    return hooks->allocate(size);
+}
+
+static void hooks_deallocate(const internal_hooks * const hooks, void *pointer)
+{
+    /* arena memory is only reclaimed by cJSON_ResetArena */
+    if (hooks->arena == NULL)
+    {
+        hooks->deallocate(pointer);
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t buffer_size, size_t block_size)
+{
+    unsigned char *start = (unsigned char*)buffer;
+    unsigned char *end = start + buffer_size;
+
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    if (start != NULL)
+    {
+        /* round the caller's buffer in to the arena alignment */
+        size_t misalignment = (size_t)start % sizeof(arena_alignment);
+        start += misalignment ? sizeof(arena_alignment) - misalignment : 0;
+        if (start > end)
+        {
+            start = end;
+        }
+    }
+    else
+    {
+        end = NULL;
+    }
+
+    arena->initial = start;
+    arena->initial_limit = end;
+    arena->blocks = NULL;
+    arena->block_size = (block_size > 0) ? block_size : 4096;
+    cJSON_ResetArena(arena);
+}
+
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    /* heap blocks stay allocated and are reused, so a steady workload stops calling malloc */
+    arena->current = NULL;
+    arena->cursor = arena->initial;
+    arena->limit = arena->initial_limit;
+}
+
+CJSON_PUBLIC(void) cJSON_FreeArena(cJSON_Arena *arena)
+{
+    cJSON_ArenaBlock *block = NULL;
+
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    block = arena->blocks;
+    while (block != NULL)
+    {
+        cJSON_ArenaBlock *next = block->next;
+        global_hooks.deallocate(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    cJSON_ResetArena(arena);
+}
 
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
@@ -240,7 +395,7 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    cJSON* node = (cJSON*)hooks_allocate(hooks, sizeof(cJSON));
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
@@ -249,6 +404,108 @@ static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
     return node;
 }
 
+typedef struct
+{
+    unsigned int hash;
+    cJSON *item;
+} object_index_slot;
+
+typedef struct cJSON_ObjectIndex cJSON_ObjectIndex;
+
+struct cJSON_ObjectIndex
+{
+    size_t mask;
+    cJSON_bool in_arena;
+    object_index_slot slots[1]; /* mask + 1 slots, open addressing with linear probing */
+};
+
+/* Marks a heap-parsed object big enough for an index that no lookup has needed yet. */
+static cJSON_ObjectIndex unbuilt_index;
+
+/* FNV-1a over the lower-cased name, so one index serves case sensitive and insensitive lookups. */
+static unsigned int hash_member_name(const unsigned char *name)
+{
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; name++)
+    {
+        hash = (hash ^ (unsigned int)tolower(*name)) * 16777619u;
+    }
+    return hash;
+}
+
+/* Members are inserted in list order, and equal names share a home slot, so probing finds the
+ * first matching member just like the linear scan does. */
+static cJSON_ObjectIndex *build_object_index(const cJSON *child, size_t count, const internal_hooks * const hooks)
+{
+    cJSON_ObjectIndex *index = NULL;
+    size_t slot_count = 4;
+
+    while (slot_count < count * 2)
+    {
+        slot_count *= 2;
+    }
+
+    index = (cJSON_ObjectIndex*)hooks_allocate(hooks, sizeof(cJSON_ObjectIndex) + (slot_count - 1) * sizeof(object_index_slot));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+    memset(index->slots, 0, slot_count * sizeof(object_index_slot));
+    index->mask = slot_count - 1;
+    index->in_arena = (hooks->arena != NULL);
+
+    for (; child != NULL; child = child->next)
+    {
+        unsigned int hash = 0;
+        size_t position = 0;
+        if (child->string == NULL)
+        {
+            continue;
+        }
+        hash = hash_member_name((const unsigned char*)child->string);
+        position = hash & index->mask;
+        while (index->slots[position].item != NULL)
+        {
+            position = (position + 1) & index->mask;
+        }
+        index->slots[position].hash = hash;
+        index->slots[position].item = (cJSON*)child;
+    }
+
+    return index;
+}
+
+static cJSON *object_index_lookup(const cJSON_ObjectIndex *index, const char *name, const cJSON_bool case_sensitive)
+{
+    unsigned int hash = hash_member_name((const unsigned char*)name);
+    size_t position = hash & index->mask;
+
+    for (; index->slots[position].item != NULL; position = (position + 1) & index->mask)
+    {
+        const object_index_slot *slot = &index->slots[position];
+        if ((slot->hash == hash) && ((case_sensitive ? strcmp(name, slot->item->string)
+                : case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)slot->item->string)) == 0))
+        {
+            return slot->item;
+        }
+    }
+
+    return NULL;
+}
+
+/* Called by everything that changes an object's member list. */
+static void drop_object_index(cJSON *object)
+{
+    if ((object != NULL) && (object->index != NULL))
+    {
+        if ((object->index != &unbuilt_index) && !object->index->in_arena)
+        {
+            global_hooks.deallocate(object->index);
+        }
+        object->index = NULL;
+    }
+}
+
 /* Delete a cJSON structure. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
 {
@@ -256,6 +513,10 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
     while (item != NULL)
     {
         next = item->next;
+        if (!(item->type & cJSON_IsReference))
+        {
+            drop_object_index(item);
+        }
         if (!(item->type & cJSON_IsReference) && (item->child != NULL))
         {
             cJSON_Delete(item->child);
@@ -293,6 +554,7 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_bool in_situ; /* strings are unescaped into content itself, which is then writable */
 } parse_buffer;
 
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
@@ -303,149 +565,521 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+/* Byte scanning kernels. Each returns how many bytes from pointer (up to end) can be
+ * skipped before the parser has to look at a byte itself. The SSE2 and AVX2 versions
+ * test 16/32 bytes per step; the best one the CPU supports is picked at load time. */
+typedef size_t (*scan_kernel)(const unsigned char *pointer, const unsigned char *end);
+
+typedef struct
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
-    size_t i = 0;
+    const char *name;
+    scan_kernel string_run;     /* bytes before the next '"' or '\\' */
+    scan_kernel whitespace_run; /* bytes <= 32 (what parsing treats as whitespace) */
+    scan_kernel minify_run;     /* bytes other than ' ', '\t', '\r', '\n', '/' and '"' */
+} scanner;
 
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+static size_t scalar_string_run(const unsigned char *pointer, const unsigned char *end)
+{
+    const unsigned char *start = pointer;
+    while ((pointer < end) && (*pointer != '\"') && (*pointer != '\\'))
     {
-        return false;
+        pointer++;
     }
+    return (size_t)(pointer - start);
+}
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+static size_t scalar_whitespace_run(const unsigned char *pointer, const unsigned char *end)
+{
+    const unsigned char *start = pointer;
+    while ((pointer < end) && (*pointer <= 32))
     {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_c_string[i] = buffer_at_offset(input_buffer)[i];
-                break;
-
-            case '.':
-                number_c_string[i] = decimal_point;
-                break;
-
-            default:
-                goto loop_end;
-        }
+        pointer++;
     }
-loop_end:
-    number_c_string[i] = '\0';
+    return (size_t)(pointer - start);
+}
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
+static size_t scalar_minify_run(const unsigned char *pointer, const unsigned char *end)
+{
+    const unsigned char *start = pointer;
+    while ((pointer < end) && (*pointer != ' ') && (*pointer != '\t') && (*pointer != '\r')
+            && (*pointer != '\n') && (*pointer != '/') && (*pointer != '\"'))
     {
-        return false; /* parse_error */
+        pointer++;
     }
+    return (size_t)(pointer - start);
+}
 
-    item->valuedouble = number;
+static const scanner scalar_scanner = { "scalar", scalar_string_run, scalar_whitespace_run, scalar_minify_run };
 
-    /* use saturation in case of overflow */
-    if (number >= INT_MAX)
-    {
-        item->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
-    {
-        item->valueint = INT_MIN;
-    }
-    else
-    {
-        item->valueint = (int)number;
-    }
+/* Not a kernel set: selecting it makes the call sites fall back to the byte-at-a-time
+ * loops they had before the kernels, as a reference for checking the kernels against.
+ * Its functions are only there for call sites that never had a byte loop of their own. */
+static const scanner bytewise_scanner = { "bytewise", scalar_string_run, scalar_whitespace_run, scalar_minify_run };
+#define scanning_bytewise() (active_scanner == &bytewise_scanner)
 
-    item->type = cJSON_Number;
+#if CJSON_X86_SIMD
+static size_t sse2_string_run(const unsigned char *pointer, const unsigned char *end)
+{
+    const unsigned char *start = pointer;
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    return true;
+    for (; (end - pointer) >= 16; pointer += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)pointer);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+        if (mask != 0)
+        {
+            return (size_t)(pointer - start) + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return (size_t)(pointer - start) + scalar_string_run(pointer, end);
 }
 
-/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+static size_t sse2_whitespace_run(const unsigned char *pointer, const unsigned char *end)
 {
-    if (number >= INT_MAX)
-    {
-        object->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
-    {
-        object->valueint = INT_MIN;
-    }
-    else
+    const unsigned char *start = pointer;
+    const __m128i space = _mm_set1_epi8(32);
+
+    for (; (end - pointer) >= 16; pointer += 16)
     {
-        object->valueint = (int)number;
+        __m128i block = _mm_loadu_si128((const __m128i*)pointer);
+        /* unsigned byte <= 32 exactly when min(byte, 32) == byte */
+        int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(block, space), block)) & 0xFFFF;
+        if (mask != 0)
+        {
+            return (size_t)(pointer - start) + (size_t)__builtin_ctz((unsigned int)mask);
+        }
     }
-
-    return object->valuedouble = number;
+    return (size_t)(pointer - start) + scalar_whitespace_run(pointer, end);
 }
 
-/* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
-CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+static size_t sse2_minify_run(const unsigned char *pointer, const unsigned char *end)
 {
-    char *copy = NULL;
-    size_t v1_len;
-    size_t v2_len;
-    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
-    if ((object == NULL) || !(object->type & cJSON_String) || (object->type & cJSON_IsReference))
-    {
-        return NULL;
-    }
-    /* return NULL if the object is corrupted or valuestring is NULL */
-    if (object->valuestring == NULL || valuestring == NULL)
-    {
-        return NULL;
+    const unsigned char *start = pointer;
+
+    for (; (end - pointer) >= 16; pointer += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)pointer);
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+        int mask;
+        special = _mm_or_si128(special,
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('/')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\"'))));
+        mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return (size_t)(pointer - start) + (size_t)__builtin_ctz((unsigned int)mask);
+        }
     }
+    return (size_t)(pointer - start) + scalar_minify_run(pointer, end);
+}
 
-    v1_len = strlen(valuestring);
-    v2_len = strlen(object->valuestring);
+static const scanner sse2_scanner = { "sse2", sse2_string_run, sse2_whitespace_run, sse2_minify_run };
 
-    if (v1_len <= v2_len)
+__attribute__((target("avx2")))
+static size_t avx2_string_run(const unsigned char *pointer, const unsigned char *end)
+{
+    const unsigned char *start = pointer;
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+
+    for (; (end - pointer) >= 32; pointer += 32)
     {
-        /* strcpy does not handle overlapping string: [X1, X2] [Y1, Y2] => X2 < Y1 or Y2 < X1 */
-        if (!( valuestring + v1_len < object->valuestring || object->valuestring + v2_len < valuestring ))
+        __m256i block = _mm256_loadu_si256((const __m256i*)pointer);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+        if (mask != 0)
         {
-            return NULL;
+            return (size_t)(pointer - start) + (size_t)__builtin_ctz(mask);
         }
-        strcpy(object->valuestring, valuestring);
-        return object->valuestring;
-    }
-    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
-    if (copy == NULL)
-    {
-        return NULL;
     }
-    if (object->valuestring != NULL)
+    return (size_t)(pointer - start) + sse2_string_run(pointer, end);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_whitespace_run(const unsigned char *pointer, const unsigned char *end)
+{
+    const unsigned char *start = pointer;
+    const __m256i space = _mm256_set1_epi8(32);
+
+    for (; (end - pointer) >= 32; pointer += 32)
     {
-        cJSON_free(object->valuestring);
+        __m256i block = _mm256_loadu_si256((const __m256i*)pointer);
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(block, space), block));
+        if (mask != 0)
+        {
+            return (size_t)(pointer - start) + (size_t)__builtin_ctz(mask);
+        }
     }
-    object->valuestring = copy;
-
-    return copy;
+    return (size_t)(pointer - start) + sse2_whitespace_run(pointer, end);
 }
 
-typedef struct
+__attribute__((target("avx2")))
+static size_t avx2_minify_run(const unsigned char *pointer, const unsigned char *end)
 {
-    unsigned char *buffer;
+    const unsigned char *start = pointer;
+
+    for (; (end - pointer) >= 32; pointer += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)pointer);
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))));
+        unsigned int mask;
+        special = _mm256_or_si256(special,
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('/')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\"'))));
+        mask = (unsigned int)_mm256_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return (size_t)(pointer - start) + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return (size_t)(pointer - start) + sse2_minify_run(pointer, end);
+}
+
+static const scanner avx2_scanner = { "avx2", avx2_string_run, avx2_whitespace_run, avx2_minify_run };
+
+static const scanner *active_scanner = &sse2_scanner;
+
+__attribute__((constructor))
+static void select_scanner(void)
+{
+    __builtin_cpu_init();
+    active_scanner = __builtin_cpu_supports("avx2") ? &avx2_scanner : &sse2_scanner;
+}
+#else
+static const scanner *active_scanner = &scalar_scanner;
+#endif
+
+CJSON_PUBLIC(const char*) cJSON_GetScanner(void)
+{
+    return active_scanner->name;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_UseScanner(const char *name)
+{
+    const scanner *candidates[4];
+    size_t count = 0;
+    size_t i = 0;
+
+    candidates[count++] = &bytewise_scanner;
+    candidates[count++] = &scalar_scanner;
+#if CJSON_X86_SIMD
+    candidates[count++] = &sse2_scanner;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        candidates[count++] = &avx2_scanner;
+    }
+#endif
+
+    for (i = 0; (name != NULL) && (i < count); i++)
+    {
+        if (strcmp(name, candidates[i]->name) == 0)
+        {
+            active_scanner = candidates[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Exact powers of ten representable in a double. */
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_MANTISSA ((unsigned long long)1 << 53)
+
+/* Parses a number straight from the input without locale lookups when the result is
+ * exactly computable (Clinger's fast path): at most 19 significant digits whose value
+ * fits in 53 bits, scaled by an exact power of ten. One correctly rounded multiply or
+ * divide then gives the same double as strtod. Returns false for anything else
+ * (long mantissas, large exponents, malformed text), which goes through strtod. */
+static cJSON_bool parse_number_fast(const unsigned char *input, size_t available, double *number, size_t *length)
+{
+    const unsigned char *pointer = input;
+    const unsigned char *end = input + available;
+    unsigned long long mantissa = 0;
+    int significant_digits = 0;
+    int digits = 0;
+    int exponent = 0;
+    cJSON_bool negative = false;
+    double value = 0;
+
+#if !defined(FLT_EVAL_METHOD) || (FLT_EVAL_METHOD != 0)
+    /* excess precision would round twice */
+    return false;
+#endif
+
+    if ((pointer < end) && ((*pointer == '-') || (*pointer == '+')))
+    {
+        negative = (*pointer == '-');
+        pointer++;
+    }
+
+    for (; (pointer < end) && (*pointer >= '0') && (*pointer <= '9'); pointer++, digits++)
+    {
+        if ((mantissa == 0) && (*pointer == '0'))
+        {
+            continue;
+        }
+        if (++significant_digits > 19)
+        {
+            return false;
+        }
+        mantissa = mantissa * 10 + (unsigned long long)(*pointer - '0');
+    }
+
+    if ((pointer < end) && (*pointer == '.'))
+    {
+        for (pointer++; (pointer < end) && (*pointer >= '0') && (*pointer <= '9'); pointer++, digits++)
+        {
+            exponent--;
+            if ((mantissa == 0) && (*pointer == '0'))
+            {
+                continue;
+            }
+            if (++significant_digits > 19)
+            {
+                return false;
+            }
+            mantissa = mantissa * 10 + (unsigned long long)(*pointer - '0');
+        }
+    }
+
+    if (digits == 0)
+    {
+        return false;
+    }
+
+    /* an exponent only counts when digits follow, as with strtod */
+    if ((pointer < end) && ((*pointer == 'e') || (*pointer == 'E')))
+    {
+        const unsigned char *exponent_pointer = pointer + 1;
+        cJSON_bool exponent_negative = false;
+        int explicit_exponent = 0;
+
+        if ((exponent_pointer < end) && ((*exponent_pointer == '-') || (*exponent_pointer == '+')))
+        {
+            exponent_negative = (*exponent_pointer == '-');
+            exponent_pointer++;
+        }
+        if ((exponent_pointer < end) && (*exponent_pointer >= '0') && (*exponent_pointer <= '9'))
+        {
+            for (; (exponent_pointer < end) && (*exponent_pointer >= '0') && (*exponent_pointer <= '9'); exponent_pointer++)
+            {
+                if (explicit_exponent > 10000)
+                {
+                    return false;
+                }
+                explicit_exponent = explicit_exponent * 10 + (*exponent_pointer - '0');
+            }
+            exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+            pointer = exponent_pointer;
+        }
+    }
+
+    /* the old path copies at most 63 characters; leave longer numbers to it */
+    if ((size_t)(pointer - input) > 63)
+    {
+        return false;
+    }
+
+    if (mantissa == 0)
+    {
+        value = 0.0;
+    }
+    else if (mantissa > MAX_EXACT_MANTISSA)
+    {
+        return false;
+    }
+    else if ((exponent >= -22) && (exponent <= 22))
+    {
+        value = (double)mantissa;
+        value = (exponent < 0) ? value / exact_powers_of_ten[-exponent] : value * exact_powers_of_ten[exponent];
+    }
+    else if ((exponent > 22) && (exponent <= 22 + 15))
+    {
+        /* move the excess of the exponent into the mantissa while it stays exact */
+        int shift = exponent - 22;
+        while ((shift > 0) && (mantissa <= MAX_EXACT_MANTISSA / 10))
+        {
+            mantissa *= 10;
+            shift--;
+        }
+        if (shift > 0)
+        {
+            return false;
+        }
+        value = (double)mantissa * exact_powers_of_ten[22];
+    }
+    else
+    {
+        return false;
+    }
+
+    *number = negative ? -value : value;
+    *length = (size_t)(pointer - input);
+    return true;
+}
+
+/* Parse the input text to generate a number, and populate the result into item. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    double number = 0;
+    unsigned char *after_end = NULL;
+    unsigned char number_c_string[64];
+    unsigned char decimal_point = 0;
+    size_t i = 0;
+    size_t length = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false;
+    }
+
+    if (parse_number_fast(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number, &length))
+    {
+        goto parsed;
+    }
+
+    decimal_point = get_decimal_point();
+
+    /* copy the number into a temporary buffer and replace '.' with the decimal point
+     * of the current locale (for strtod)
+     * This also takes care of '\0' not necessarily being available for marking the end of the input */
+    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+    {
+        switch (buffer_at_offset(input_buffer)[i])
+        {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '+':
+            case '-':
+            case 'e':
+            case 'E':
+                number_c_string[i] = buffer_at_offset(input_buffer)[i];
+                break;
+
+            case '.':
+                number_c_string[i] = decimal_point;
+                break;
+
+            default:
+                goto loop_end;
+        }
+    }
+loop_end:
+    number_c_string[i] = '\0';
+
+    number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
+    {
+        return false; /* parse_error */
+    }
+    length = (size_t)(after_end - number_c_string);
+
+parsed:
+    item->valuedouble = number;
+
+    /* use saturation in case of overflow */
+    if (number >= INT_MAX)
+    {
+        item->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        item->valueint = INT_MIN;
+    }
+    else
+    {
+        item->valueint = (int)number;
+    }
+
+    item->type = cJSON_Number;
+
+    input_buffer->offset += length;
+    return true;
+}
+
+/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+{
+    if (number >= INT_MAX)
+    {
+        object->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
+    }
+
+    return object->valuedouble = number;
+}
+
+/* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
+CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+{
+    char *copy = NULL;
+    size_t v1_len;
+    size_t v2_len;
+    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
+    if ((object == NULL) || !(object->type & cJSON_String) || (object->type & cJSON_IsReference))
+    {
+        return NULL;
+    }
+    /* return NULL if the object is corrupted or valuestring is NULL */
+    if (object->valuestring == NULL || valuestring == NULL)
+    {
+        return NULL;
+    }
+
+    v1_len = strlen(valuestring);
+    v2_len = strlen(object->valuestring);
+
+    if (v1_len <= v2_len)
+    {
+        /* strcpy does not handle overlapping string: [X1, X2] [Y1, Y2] => X2 < Y1 or Y2 < X1 */
+        if (!( valuestring + v1_len < object->valuestring || object->valuestring + v2_len < valuestring ))
+        {
+            return NULL;
+        }
+        strcpy(object->valuestring, valuestring);
+        return object->valuestring;
+    }
+    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    if (object->valuestring != NULL)
+    {
+        cJSON_free(object->valuestring);
+    }
+    object->valuestring = copy;
+
+    return copy;
+}
+
+typedef struct
+{
+    unsigned char *buffer;
     size_t length;
     size_t offset;
     size_t depth; /* current nesting depth (for formatted printing) */
@@ -560,17 +1194,308 @@ static cJSON_bool compare_double(double a, double b)
     return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* Shortest round-trip formatting with Grisu2 (Florian Loitsch, "Printing Floating-Point
+ * Numbers Quickly and Accurately with Integers", 2010). The digits always read back as
+ * the same double and are the shortest such digits for all but a tiny fraction of inputs. */
+typedef struct
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
-
+    unsigned long long f;
+    int e;
+} diy_fp;
+
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_HIDDEN_BIT 0x0010000000000000ULL
+#define DP_EXPONENT_BIAS (0x3FF + 52)
+
+/* 10^k for k = -348, -340, ..., 340 as f * 2^e with f normalized to 64 bits and rounded */
+static const diy_fp cached_powers[] = {
+    { 0xFA8FD5A0081C0288ULL, -1220 }, { 0xBAAEE17FA23EBF76ULL, -1193 },
+    { 0x8B16FB203055AC76ULL, -1166 }, { 0xCF42894A5DCE35EAULL, -1140 },
+    { 0x9A6BB0AA55653B2DULL, -1113 }, { 0xE61ACF033D1A45DFULL, -1087 },
+    { 0xAB70FE17C79AC6CAULL, -1060 }, { 0xFF77B1FCBEBCDC4FULL, -1034 },
+    { 0xBE5691EF416BD60CULL, -1007 }, { 0x8DD01FAD907FFC3CULL, -980 },
+    { 0xD3515C2831559A83ULL, -954 }, { 0x9D71AC8FADA6C9B5ULL, -927 },
+    { 0xEA9C227723EE8BCBULL, -901 }, { 0xAECC49914078536DULL, -874 },
+    { 0x823C12795DB6CE57ULL, -847 }, { 0xC21094364DFB5637ULL, -821 },
+    { 0x9096EA6F3848984FULL, -794 }, { 0xD77485CB25823AC7ULL, -768 },
+    { 0xA086CFCD97BF97F4ULL, -741 }, { 0xEF340A98172AACE5ULL, -715 },
+    { 0xB23867FB2A35B28EULL, -688 }, { 0x84C8D4DFD2C63F3BULL, -661 },
+    { 0xC5DD44271AD3CDBAULL, -635 }, { 0x936B9FCEBB25C996ULL, -608 },
+    { 0xDBAC6C247D62A584ULL, -582 }, { 0xA3AB66580D5FDAF6ULL, -555 },
+    { 0xF3E2F893DEC3F126ULL, -529 }, { 0xB5B5ADA8AAFF80B8ULL, -502 },
+    { 0x87625F056C7C4A8BULL, -475 }, { 0xC9BCFF6034C13053ULL, -449 },
+    { 0x964E858C91BA2655ULL, -422 }, { 0xDFF9772470297EBDULL, -396 },
+    { 0xA6DFBD9FB8E5B88FULL, -369 }, { 0xF8A95FCF88747D94ULL, -343 },
+    { 0xB94470938FA89BCFULL, -316 }, { 0x8A08F0F8BF0F156BULL, -289 },
+    { 0xCDB02555653131B6ULL, -263 }, { 0x993FE2C6D07B7FACULL, -236 },
+    { 0xE45C10C42A2B3B06ULL, -210 }, { 0xAA242499697392D3ULL, -183 },
+    { 0xFD87B5F28300CA0EULL, -157 }, { 0xBCE5086492111AEBULL, -130 },
+    { 0x8CBCCC096F5088CCULL, -103 }, { 0xD1B71758E219652CULL, -77 },
+    { 0x9C40000000000000ULL, -50 }, { 0xE8D4A51000000000ULL, -24 },
+    { 0xAD78EBC5AC620000ULL, 3 }, { 0x813F3978F8940984ULL, 30 },
+    { 0xC097CE7BC90715B3ULL, 56 }, { 0x8F7E32CE7BEA5C70ULL, 83 },
+    { 0xD5D238A4ABE98068ULL, 109 }, { 0x9F4F2726179A2245ULL, 136 },
+    { 0xED63A231D4C4FB27ULL, 162 }, { 0xB0DE65388CC8ADA8ULL, 189 },
+    { 0x83C7088E1AAB65DBULL, 216 }, { 0xC45D1DF942711D9AULL, 242 },
+    { 0x924D692CA61BE758ULL, 269 }, { 0xDA01EE641A708DEAULL, 295 },
+    { 0xA26DA3999AEF774AULL, 322 }, { 0xF209787BB47D6B85ULL, 348 },
+    { 0xB454E4A179DD1877ULL, 375 }, { 0x865B86925B9BC5C2ULL, 402 },
+    { 0xC83553C5C8965D3DULL, 428 }, { 0x952AB45CFA97A0B3ULL, 455 },
+    { 0xDE469FBD99A05FE3ULL, 481 }, { 0xA59BC234DB398C25ULL, 508 },
+    { 0xF6C69A72A3989F5CULL, 534 }, { 0xB7DCBF5354E9BECEULL, 561 },
+    { 0x88FCF317F22241E2ULL, 588 }, { 0xCC20CE9BD35C78A5ULL, 614 },
+    { 0x98165AF37B2153DFULL, 641 }, { 0xE2A0B5DC971F303AULL, 667 },
+    { 0xA8D9D1535CE3B396ULL, 694 }, { 0xFB9B7CD9A4A7443CULL, 720 },
+    { 0xBB764C4CA7A44410ULL, 747 }, { 0x8BAB8EEFB6409C1AULL, 774 },
+    { 0xD01FEF10A657842CULL, 800 }, { 0x9B10A4E5E9913129ULL, 827 },
+    { 0xE7109BFBA19C0C9DULL, 853 }, { 0xAC2820D9623BF429ULL, 880 },
+    { 0x80444B5E7AA7CF85ULL, 907 }, { 0xBF21E44003ACDD2DULL, 933 },
+    { 0x8E679C2F5E44FF8FULL, 960 }, { 0xD433179D9C8CB841ULL, 986 },
+    { 0x9E19DB92B4E31BA9ULL, 1013 }, { 0xEB96BF6EBADF77D9ULL, 1039 },
+    { 0xAF87023B9BF0EE6BULL, 1066 }
+};
+
+static diy_fp diy_fp_multiply(diy_fp x, diy_fp y)
+{
+    const unsigned long long mask = 0xFFFFFFFFULL;
+    unsigned long long a = x.f >> 32;
+    unsigned long long b = x.f & mask;
+    unsigned long long c = y.f >> 32;
+    unsigned long long d = y.f & mask;
+    unsigned long long ac = a * c;
+    unsigned long long bc = b * c;
+    unsigned long long ad = a * d;
+    unsigned long long bd = b * d;
+    unsigned long long middle = (bd >> 32) + (ad & mask) + (bc & mask);
+    diy_fp product;
+
+    middle += 1ULL << 31; /* round the dropped low half */
+    product.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    product.e = x.e + y.e + 64;
+    return product;
+}
+
+static diy_fp diy_fp_normalize(diy_fp x)
+{
+    while (!(x.f & 0x8000000000000000ULL))
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/* The value and the midpoints to its neighbours, with the boundaries sharing an exponent. */
+static void diy_fp_boundaries(double value, diy_fp *w, diy_fp *minus, diy_fp *plus)
+{
+    unsigned long long bits = 0;
+    int biased_exponent = 0;
+    diy_fp v;
+
+    memcpy(&bits, &value, sizeof(bits));
+    biased_exponent = (int)((bits >> 52) & 0x7FF);
+    v.f = bits & DP_SIGNIFICAND_MASK;
+    if (biased_exponent != 0)
+    {
+        v.f += DP_HIDDEN_BIT;
+        v.e = biased_exponent - DP_EXPONENT_BIAS;
+    }
+    else
+    {
+        v.e = 1 - DP_EXPONENT_BIAS;
+    }
+
+    plus->f = (v.f << 1) + 1;
+    plus->e = v.e - 1;
+    *plus = diy_fp_normalize(*plus);
+
+    /* the gap below a power of two is half the gap above it */
+    if (v.f == DP_HIDDEN_BIT)
+    {
+        minus->f = (v.f << 2) - 1;
+        minus->e = v.e - 2;
+    }
+    else
+    {
+        minus->f = (v.f << 1) - 1;
+        minus->e = v.e - 1;
+    }
+    minus->f <<= minus->e - plus->e;
+    minus->e = plus->e;
+
+    *w = diy_fp_normalize(v);
+}
+
+/* Picks the cached power c_k so that w * c_k has a binary exponent in [-60, -32]; returns it and -k. */
+static diy_fp cached_power(int binary_exponent, int *decimal_exponent)
+{
+    double dk = (-61 - binary_exponent) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    size_t index = 0;
+
+    if ((dk - k) > 0.0)
+    {
+        k++;
+    }
+    index = (size_t)((k >> 3) + 1);
+    *decimal_exponent = -(-348 + (int)index * 8);
+    return cached_powers[index];
+}
+
+static void grisu_round(char *buffer, int length, unsigned long long delta, unsigned long long rest,
+        unsigned long long ten_kappa, unsigned long long wp_w)
+{
+    while ((rest < wp_w) && ((delta - rest) >= ten_kappa)
+            && (((rest + ten_kappa) < wp_w) || ((wp_w - rest) > (rest + ten_kappa - wp_w))))
+    {
+        buffer[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static void grisu_digits(diy_fp w, diy_fp mp, unsigned long long delta, char *buffer, int *length, int *decimal_exponent)
+{
+    static const unsigned int powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    const int shift = -mp.e;
+    const unsigned long long one = 1ULL << shift;
+    const unsigned long long wp_w = mp.f - w.f;
+    unsigned int p1 = (unsigned int)(mp.f >> shift);
+    unsigned long long p2 = mp.f & (one - 1);
+    int kappa = 10;
+
+    while ((kappa > 1) && (p1 < powers_of_ten[kappa - 1]))
+    {
+        kappa--;
+    }
+
+    *length = 0;
+    while (kappa > 0)
+    {
+        unsigned long long rest = 0;
+        unsigned int digit = p1 / powers_of_ten[kappa - 1];
+        p1 %= powers_of_ten[kappa - 1];
+        if ((digit != 0) || (*length != 0))
+        {
+            buffer[(*length)++] = (char)('0' + digit);
+        }
+        kappa--;
+        rest = ((unsigned long long)p1 << shift) + p2;
+        if (rest <= delta)
+        {
+            *decimal_exponent += kappa;
+            grisu_round(buffer, *length, delta, rest, (unsigned long long)powers_of_ten[kappa] << shift, wp_w);
+            return;
+        }
+    }
+
+    for (;;)
+    {
+        unsigned int digit = 0;
+        p2 *= 10;
+        delta *= 10;
+        digit = (unsigned int)(p2 >> shift);
+        if ((digit != 0) || (*length != 0))
+        {
+            buffer[(*length)++] = (char)('0' + digit);
+        }
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            *decimal_exponent += kappa;
+            grisu_round(buffer, *length, delta, p2, one, (-kappa < 10) ? wp_w * powers_of_ten[-kappa] : 0);
+            return;
+        }
+    }
+}
+
+/* Writes the digits of a positive finite value; value == digits * 10^decimal_exponent. */
+static void grisu2(double value, char *buffer, int *length, int *decimal_exponent)
+{
+    diy_fp w, minus, plus, c_k;
+
+    diy_fp_boundaries(value, &w, &minus, &plus);
+    c_k = cached_power(plus.e, decimal_exponent);
+    w = diy_fp_multiply(w, c_k);
+    plus = diy_fp_multiply(plus, c_k);
+    minus = diy_fp_multiply(minus, c_k);
+    /* stay strictly inside the rounding interval */
+    minus.f++;
+    plus.f--;
+    grisu_digits(w, plus, plus.f - minus.f, buffer, length, decimal_exponent);
+}
+
+/* Lays the digits out like JavaScript's Number.prototype.toString (1e21 and 1e-7 switch to
+ * exponent notation) with a %g-style signed exponent. Returns the length written. */
+static int format_shortest(double value, char *output)
+{
+    char digits[20];
+    int length = 0;
+    int exponent = 0;
+    int point = 0;
+    int written = 0;
+    int i = 0;
+
+    if (value < 0)
+    {
+        output[written++] = '-';
+        value = -value;
+    }
+    grisu2(value, digits, &length, &exponent);
+    point = length + exponent; /* digits[0] is worth 10^(point - 1) */
+
+    if ((length <= point) && (point <= 21))
+    {
+        memcpy(output + written, digits, (size_t)length);
+        written += length;
+        for (i = length; i < point; i++)
+        {
+            output[written++] = '0';
+        }
+    }
+    else if ((0 < point) && (point <= 21))
+    {
+        memcpy(output + written, digits, (size_t)point);
+        written += point;
+        output[written++] = '.';
+        memcpy(output + written, digits + point, (size_t)(length - point));
+        written += length - point;
+    }
+    else if ((-6 < point) && (point <= 0))
+    {
+        output[written++] = '0';
+        output[written++] = '.';
+        for (i = point; i < 0; i++)
+        {
+            output[written++] = '0';
+        }
+        memcpy(output + written, digits, (size_t)length);
+        written += length;
+    }
+    else
+    {
+        output[written++] = digits[0];
+        if (length > 1)
+        {
+            output[written++] = '.';
+            memcpy(output + written, digits + 1, (size_t)(length - 1));
+            written += length - 1;
+        }
+        written += sprintf(output + written, "e%+d", point - 1);
+    }
+
+    output[written] = '\0';
+    return written;
+}
+
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    double d = item->valuedouble;
+    int length = 0;
+    unsigned char number_buffer[32] = {0}; /* temporary buffer to print the number into */
+
     if (output_buffer == NULL)
     {
         return false;
@@ -587,15 +1512,8 @@ static cJSON_bool print_number(const cJSON * const item, printbuffer * const out
     }
     else
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
-
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
-        {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
-        }
+        /* shortest digits that parse back to d, always with '.' whatever the locale */
+        length = format_shortest(d, (char*)number_buffer);
     }
 
     /* sprintf failed or buffer overrun occurred */
@@ -611,19 +1529,7 @@ static cJSON_bool print_number(const cJSON * const item, printbuffer * const out
         return false;
     }
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
-    {
-        if (number_buffer[i] == decimal_point)
-        {
-            output_pointer[i] = '.';
-            continue;
-        }
-
-        output_pointer[i] = number_buffer[i];
-    }
-    output_pointer[i] = '\0';
+    memcpy(output_pointer, number_buffer, (size_t)length + 1);
 
     output_buffer->offset += (size_t)length;
 
@@ -806,32 +1712,65 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        const unsigned char *content_end = input_buffer->content + input_buffer->length;
+        if (scanning_bytewise())
+        {
+            while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+            {
+                /* is escape sequence */
+                if (input_end[0] == '\\')
+                {
+                    if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
+                    {
+                        /* prevent buffer overflow when last input character is a backslash */
+                        goto fail;
+                    }
+                    skipped_bytes++;
+                    input_end++;
+                }
+                input_end++;
+            }
+        }
+        else
         {
-            /* is escape sequence */
-            if (input_end[0] == '\\')
+            for (;;)
             {
+                input_end += active_scanner->string_run(input_end, content_end);
+                if ((input_end >= content_end) || (*input_end == '\"'))
+                {
+                    break;
+                }
+
+                /* escape sequence */
                 if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
                 {
                     /* prevent buffer overflow when last input character is a backslash */
                     goto fail;
                 }
                 skipped_bytes++;
-                input_end++;
+                input_end += 2;
             }
-            input_end++;
         }
         if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
         {
             goto fail; /* string ended unexpectedly */
         }
 
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
+        if (input_buffer->in_situ)
         {
-            goto fail; /* allocation failure */
+            /* unescaping never grows a string, so it can be written over itself,
+             * with the terminator at most replacing the closing quote */
+            output = (unsigned char*)input_pointer;
+        }
+        else
+        {
+            /* This is at most how much we need for the output */
+            allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+            output = (unsigned char*)hooks_allocate(&input_buffer->hooks, allocation_length + sizeof(""));
+            if (output == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
         }
     }
 
@@ -841,7 +1780,14 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     {
         if (*input_pointer != '\\')
         {
-            *output_pointer++ = *input_pointer++;
+            /* copy everything up to the next escape in one go */
+            size_t run = scanning_bytewise() ? 1 : active_scanner->string_run(input_pointer, input_end);
+            if (output_pointer != input_pointer)
+            {
+                memmove(output_pointer, input_pointer, run);
+            }
+            output_pointer += run;
+            input_pointer += run;
         }
         /* escape sequence */
         else
@@ -896,6 +1842,11 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     *output_pointer = '\0';
 
     item->type = cJSON_String;
+    if (input_buffer->in_situ)
+    {
+        /* the text belongs to the caller, cJSON_Delete must not free it */
+        item->type |= cJSON_IsReference;
+    }
     item->valuestring = (char*)output;
 
     input_buffer->offset = (size_t) (input_end - input_buffer->content);
@@ -904,9 +1855,9 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && !input_buffer->in_situ)
     {
-        input_buffer->hooks.deallocate(output);
+        hooks_deallocate(&input_buffer->hooks, output);
         output = NULL;
     }
 
@@ -1067,9 +2018,17 @@ static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
         return buffer;
     }
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    if (scanning_bytewise())
+    {
+        while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+        {
+           buffer->offset++;
+        }
+    }
+    /* runs are usually zero or one byte long, only call the kernel when there is one */
+    else if (buffer_at_offset(buffer)[0] <= 32)
     {
-       buffer->offset++;
+        buffer->offset += active_scanner->whitespace_run(buffer_at_offset(buffer), buffer->content + buffer->length);
     }
 
     if (buffer->offset == buffer->length)
@@ -1111,10 +2070,55 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
+static cJSON *parse_with_hooks(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, const internal_hooks * const hooks, cJSON_bool in_situ);
+
 /* Parse an object - create a new root, and populate. */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    return parse_with_hooks(value, buffer_length, return_parse_end, require_null_terminated, &global_hooks, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArena(cJSON_Arena *arena, const char *value)
+{
+    if (value == NULL)
+    {
+        return NULL;
+    }
+    return cJSON_ParseWithLengthInArena(arena, value, strlen(value) + sizeof(""));
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthInArena(cJSON_Arena *arena, const char *value, size_t buffer_length)
+{
+    internal_hooks hooks = global_hooks;
+
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+    hooks.arena = arena;
+    return parse_with_hooks(value, buffer_length, NULL, false, &hooks, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length)
+{
+    return parse_with_hooks(value, buffer_length, NULL, false, &global_hooks, true);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituInArena(cJSON_Arena *arena, char *value, size_t buffer_length)
+{
+    internal_hooks hooks = global_hooks;
+
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+    hooks.arena = arena;
+    return parse_with_hooks(value, buffer_length, NULL, false, &hooks, true);
+}
+
+static cJSON *parse_with_hooks(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, const internal_hooks * const hooks, cJSON_bool in_situ)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1129,9 +2133,10 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.content = (const unsigned char*)value;
     buffer.length = buffer_length;
     buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    buffer.hooks = *hooks;
+    buffer.in_situ = in_situ;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = cJSON_New_Item(hooks);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1160,7 +2165,7 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     return item;
 
 fail:
-    if (item != NULL)
+    if ((item != NULL) && (hooks->arena == NULL))
     {
         cJSON_Delete(item);
     }
@@ -1284,7 +2289,7 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
 
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 } };
 
     if (prebuffer < 0)
     {
@@ -1315,7 +2320,7 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 } };
 
     if ((length < 0) || (buffer == NULL))
     {
@@ -1551,7 +2556,7 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
         cJSON_Delete(head);
     }
@@ -1626,6 +2631,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
 {
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
+    size_t member_count = 0;
 
     if (input_buffer->depth >= CJSON_NESTING_LIMIT)
     {
@@ -1677,6 +2683,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
             new_item->prev = current_item;
             current_item = new_item;
         }
+        member_count++;
 
         if (cannot_access_at_index(input_buffer, 1))
         {
@@ -1695,6 +2702,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ)
+        {
+            /* the key lives in the caller's buffer */
+            current_item->type |= cJSON_StringIsConst;
+        }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1708,6 +2720,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->in_situ)
+        {
+            /* parsing the value reset the type */
+            current_item->type |= cJSON_StringIsConst;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
@@ -1726,12 +2743,22 @@ success:
 
     item->type = cJSON_Object;
     item->child = head;
+    if ((member_count >= CJSON_INDEX_THRESHOLD) && (input_buffer->hooks.arena != NULL))
+    {
+        /* without an index lookups just stay linear, so allocation failure is not an error */
+        item->index = build_object_index(head, member_count, &input_buffer->hooks);
+    }
+    else if (member_count >= CJSON_INDEX_THRESHOLD)
+    {
+        /* on the heap the index waits for a lookup that needs it, see get_object_item() */
+        item->index = &unbuilt_index;
+    }
 
     input_buffer->offset++;
     return true;
 
 fail:
-    if (head != NULL)
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
         cJSON_Delete(head);
     }
@@ -1909,18 +2936,25 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    size_t walked = 0;
 
     if ((object == NULL) || (name == NULL))
     {
         return NULL;
     }
 
+    if ((object->index != NULL) && (object->index != &unbuilt_index))
+    {
+        return object_index_lookup(object->index, name, case_sensitive);
+    }
+
     current_element = object->child;
     if (case_sensitive)
     {
         while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
         {
             current_element = current_element->next;
+            walked++;
         }
     }
     else
@@ -1928,7 +2962,21 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
         while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
         {
             current_element = current_element->next;
+            walked++;
+        }
+    }
+
+    /* the first lookup that has to walk past the threshold builds the index for the ones after it */
+    if ((object->index == &unbuilt_index) && (walked >= CJSON_INDEX_THRESHOLD))
+    {
+        cJSON *indexed = (cJSON*)object;
+        size_t member_count = 0;
+        const cJSON *child = NULL;
+        for (child = object->child; child != NULL; child = child->next)
+        {
+            member_count++;
         }
+        indexed->index = build_object_index(object->child, member_count, &global_hooks);
     }
 
     if ((current_element == NULL) || (current_element->string == NULL)) {
@@ -1977,6 +3025,7 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
 
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
+    reference->index = NULL;
     reference->type |= cJSON_IsReference;
     reference->next = reference->prev = NULL;
     return reference;
@@ -1991,6 +3040,7 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
         return false;
     }
 
+    drop_object_index(array);
     child = array->child;
     /*
      * To find the last item in array quickly, we use prev in array
@@ -2220,6 +3270,8 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         return NULL;
     }
 
+    drop_object_index(parent);
+
     if (item != parent->child)
     {
         /* not the first element */
@@ -2304,6 +3356,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
         return add_item_to_array(array, newitem);
     }
 
+    drop_object_index(array);
     if (after_inserted != array->child && after_inserted->prev == NULL) {
         /* return false if after_inserted is a corrupted array item */
         return false;
@@ -2335,6 +3388,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
         return true;
     }
 
+    drop_object_index(parent);
     replacement->next = item->next;
     replacement->prev = item->prev;
 
@@ -2857,13 +3911,23 @@ static void skip_multiline_comment(char **input)
     }
 }
 
-static void minify_string(char **input, char **output) {
+static void minify_string(char **input, char **output, const char *end) {
     (*output)[0] = (*input)[0];
     *input += static_strlen("\"");
     *output += static_strlen("\"");
 
 
     for (; (*input)[0] != '\0'; (void)++(*input), ++(*output)) {
+        /* move the plain run before the next quote or backslash at once */
+        size_t run = scanning_bytewise() ? 0 : active_scanner->string_run((const unsigned char*)*input, (const unsigned char*)end);
+        if (run > 0) {
+            memmove(*output, *input, run);
+            *input += run;
+            *output += run;
+            if ((*input)[0] == '\0') {
+                return;
+            }
+        }
         (*output)[0] = (*input)[0];
 
         if ((*input)[0] == '\"') {
@@ -2882,12 +3946,15 @@ static void minify_string(char **input, char **output) {
 CJSON_PUBLIC(void) cJSON_Minify(char *json)
 {
     char *into = json;
+    const char *end = NULL;
 
     if (json == NULL)
     {
         return;
     }
 
+    end = json + strlen(json);
+
     while (json[0] != '\0')
     {
         switch (json[0])
@@ -2913,13 +3980,17 @@ CJSON_PUBLIC(void) cJSON_Minify(char *json)
                 break;
 
             case '\"':
-                minify_string(&json, (char**)&into);
+                minify_string(&json, (char**)&into, end);
                 break;
 
             default:
-                into[0] = json[0];
-                json++;
-                into++;
+            {
+                /* the byte at json is not special, so the run is at least one byte */
+                size_t run = scanning_bytewise() ? 1 : active_scanner->minify_run((const unsigned char*)json, (const unsigned char*)end);
+                memmove(into, json, run);
+                json += run;
+                into += run;
+            }
         }
     }
 
@@ -2927,6 +3998,804 @@ CJSON_PUBLIC(void) cJSON_Minify(char *json)
     *into = '\0';
 }
 
+/* On-demand path scanning: walks the text without building nodes. Structure is only
+ * checked as far as needed to find the next value, so malformed input that the
+ * scanner never reaches is not reported. */
+static void scan_skip_whitespace(parse_buffer * const buffer)
+{
+    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32) && (buffer_at_offset(buffer)[0] != '\0'))
+    {
+        buffer->offset++;
+    }
+}
+
+/* expects the opening quote, leaves the offset after the closing quote */
+static cJSON_bool scan_skip_string(parse_buffer * const buffer)
+{
+    buffer->offset++;
+    while (scanning_bytewise() && can_access_at_index(buffer, 0))
+    {
+        unsigned char c = buffer_at_offset(buffer)[0];
+        if (c == '\"')
+        {
+            buffer->offset++;
+            return true;
+        }
+        if (c == '\\')
+        {
+            buffer->offset++;
+        }
+        else if (c == '\0')
+        {
+            return false;
+        }
+        buffer->offset++;
+    }
+    if (scanning_bytewise())
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        buffer->offset += active_scanner->string_run(buffer_at_offset(buffer), buffer->content + buffer->length);
+        if (cannot_access_at_index(buffer, 0))
+        {
+            return false;
+        }
+        if (buffer_at_offset(buffer)[0] == '\"')
+        {
+            buffer->offset++;
+            return true;
+        }
+        /* backslash: skip it and the escaped character */
+        if (cannot_access_at_index(buffer, 1))
+        {
+            return false;
+        }
+        buffer->offset += 2;
+    }
+}
+
+static cJSON_bool scan_skip_value(parse_buffer * const buffer)
+{
+    size_t depth = 0;
+
+    scan_skip_whitespace(buffer);
+    do
+    {
+        unsigned char c;
+        if (cannot_access_at_index(buffer, 0))
+        {
+            return false;
+        }
+
+        c = buffer_at_offset(buffer)[0];
+        switch (c)
+        {
+            case '\"':
+                if (!scan_skip_string(buffer))
+                {
+                    return false;
+                }
+                break;
+
+            case '{':
+            case '[':
+                depth++;
+                buffer->offset++;
+                break;
+
+            case '}':
+            case ']':
+                if (depth == 0)
+                {
+                    return false;
+                }
+                depth--;
+                buffer->offset++;
+                break;
+
+            case '\0':
+                return false;
+
+            default:
+                if (depth == 0)
+                {
+                    /* number or literal: runs up to the next delimiter */
+                    size_t start = buffer->offset;
+                    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] > 32)
+                            && (strchr(",]}", buffer_at_offset(buffer)[0]) == NULL))
+                    {
+                        buffer->offset++;
+                    }
+                    return buffer->offset > start;
+                }
+                buffer->offset++;
+                break;
+        }
+    } while (depth > 0);
+
+    return true;
+}
+
+static cJSON_bool scan_slice(parse_buffer * const buffer, cJSON_Slice * const slice)
+{
+    const unsigned char *start = NULL;
+
+    scan_skip_whitespace(buffer);
+    if (cannot_access_at_index(buffer, 0))
+    {
+        return false;
+    }
+
+    start = buffer_at_offset(buffer);
+    switch (start[0])
+    {
+        case '\"': slice->type = cJSON_String; break;
+        case '{': slice->type = cJSON_Object; break;
+        case '[': slice->type = cJSON_Array; break;
+        case 't': slice->type = cJSON_True; break;
+        case 'f': slice->type = cJSON_False; break;
+        case 'n': slice->type = cJSON_NULL; break;
+        default: slice->type = cJSON_Number; break;
+    }
+
+    if (!scan_skip_value(buffer))
+    {
+        return false;
+    }
+
+    slice->start = (const char*)start;
+    slice->length = (size_t)(buffer_at_offset(buffer) - start);
+    if (slice->type == cJSON_String)
+    {
+        /* point inside the quotes */
+        slice->start++;
+        slice->length -= 2;
+    }
+
+    return true;
+}
+
+typedef struct
+{
+    cJSON_SliceCallback callback;
+    void *user_data;
+    int matches;
+    cJSON_bool stopped;
+} scan_state;
+
+/* Matches path against the value at the offset and leaves the offset after that value. */
+static cJSON_bool scan_path(parse_buffer * const buffer, const char *path, scan_state * const state)
+{
+    scan_skip_whitespace(buffer);
+    if (cannot_access_at_index(buffer, 0))
+    {
+        return false;
+    }
+
+    if (path[0] == '.')
+    {
+        path++;
+    }
+
+    if (path[0] == '\0')
+    {
+        cJSON_Slice slice;
+        if (!scan_slice(buffer, &slice))
+        {
+            return false;
+        }
+        state->matches++;
+        if (!state->callback(&slice, state->user_data))
+        {
+            state->stopped = true;
+        }
+        return true;
+    }
+
+    if (path[0] == '[')
+    {
+        const char *rest = strchr(path, ']');
+        cJSON_bool every = (path[1] == '*');
+        size_t wanted = 0;
+        size_t index = 0;
+
+        if ((rest == NULL) || (!every && ((path[1] < '0') || (path[1] > '9'))))
+        {
+            return false;
+        }
+        if (!every)
+        {
+            wanted = (size_t)strtoul(path + 1, NULL, 10);
+        }
+        rest++;
+
+        if (buffer_at_offset(buffer)[0] != '[')
+        {
+            /* not an array: no match here */
+            return scan_skip_value(buffer);
+        }
+        buffer->offset++;
+        scan_skip_whitespace(buffer);
+        if (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] == ']'))
+        {
+            buffer->offset++;
+            return true;
+        }
+
+        for (;; index++)
+        {
+            cJSON_bool matched = every || (index == wanted);
+            if (!(matched ? scan_path(buffer, rest, state) : scan_skip_value(buffer)))
+            {
+                return false;
+            }
+            if (state->stopped)
+            {
+                return true;
+            }
+
+            scan_skip_whitespace(buffer);
+            if (cannot_access_at_index(buffer, 0))
+            {
+                return false;
+            }
+            if (buffer_at_offset(buffer)[0] == ']')
+            {
+                buffer->offset++;
+                return true;
+            }
+            if (buffer_at_offset(buffer)[0] != ',')
+            {
+                return false;
+            }
+            buffer->offset++;
+        }
+    }
+    else
+    {
+        size_t name_length = strcspn(path, ".[");
+        const char *rest = path + name_length;
+
+        if (buffer_at_offset(buffer)[0] != '{')
+        {
+            return scan_skip_value(buffer);
+        }
+        buffer->offset++;
+        scan_skip_whitespace(buffer);
+        if (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] == '}'))
+        {
+            buffer->offset++;
+            return true;
+        }
+
+        for (;;)
+        {
+            const unsigned char *key = NULL;
+            size_t key_length = 0;
+
+            if (cannot_access_at_index(buffer, 0) || (buffer_at_offset(buffer)[0] != '\"'))
+            {
+                return false;
+            }
+            key = buffer_at_offset(buffer) + 1;
+            if (!scan_skip_string(buffer))
+            {
+                return false;
+            }
+            /* keys are compared as raw bytes, escapes are not decoded */
+            key_length = (size_t)(buffer_at_offset(buffer) - key) - 1;
+
+            scan_skip_whitespace(buffer);
+            if (cannot_access_at_index(buffer, 0) || (buffer_at_offset(buffer)[0] != ':'))
+            {
+                return false;
+            }
+            buffer->offset++;
+
+            if ((key_length == name_length) && (strncmp((const char*)key, path, name_length) == 0))
+            {
+                if (!scan_path(buffer, rest, state))
+                {
+                    return false;
+                }
+                if (state->stopped)
+                {
+                    return true;
+                }
+            }
+            else if (!scan_skip_value(buffer))
+            {
+                return false;
+            }
+
+            scan_skip_whitespace(buffer);
+            if (cannot_access_at_index(buffer, 0))
+            {
+                return false;
+            }
+            if (buffer_at_offset(buffer)[0] == '}')
+            {
+                buffer->offset++;
+                return true;
+            }
+            if (buffer_at_offset(buffer)[0] != ',')
+            {
+                return false;
+            }
+            buffer->offset++;
+            scan_skip_whitespace(buffer);
+        }
+    }
+}
+
+CJSON_PUBLIC(int) cJSON_ScanPath(const char *json, size_t length, const char *path, cJSON_SliceCallback callback, void *user_data)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
+    scan_state state;
+
+    if ((json == NULL) || (path == NULL) || (callback == NULL))
+    {
+        return -1;
+    }
+
+    buffer.content = (const unsigned char*)json;
+    buffer.length = length;
+    state.callback = callback;
+    state.user_data = user_data;
+    state.matches = 0;
+    state.stopped = false;
+
+    if (!scan_path(skip_utf8_bom(&buffer), path, &state) && !state.stopped)
+    {
+        return -1;
+    }
+
+    return state.matches;
+}
+
+static cJSON_bool keep_first_slice(const cJSON_Slice *slice, void *user_data)
+{
+    *(cJSON_Slice*)user_data = *slice;
+    return false;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_FindPath(const char *json, size_t length, const char *path, cJSON_Slice *slice)
+{
+    if (slice == NULL)
+    {
+        return false;
+    }
+
+    return cJSON_ScanPath(json, length, path, keep_first_slice, slice) > 0;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_SliceToNumber(const cJSON_Slice *slice, double *number)
+{
+    cJSON item;
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
+
+    if ((slice == NULL) || (number == NULL) || (slice->type != cJSON_Number))
+    {
+        return false;
+    }
+
+    memset(&item, 0, sizeof(item));
+    buffer.content = (const unsigned char*)slice->start;
+    buffer.length = slice->length;
+    if (!parse_number(&item, &buffer) || (buffer.offset != slice->length))
+    {
+        return false;
+    }
+
+    *number = item.valuedouble;
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_SliceToString(const cJSON_Slice *slice, char *buffer, size_t size)
+{
+    const unsigned char *input = NULL;
+    const unsigned char *input_end = NULL;
+    unsigned char *output = (unsigned char*)buffer;
+    unsigned char *output_end = NULL;
+
+    if ((slice == NULL) || (buffer == NULL) || (size == 0) || (slice->type != cJSON_String))
+    {
+        return false;
+    }
+
+    input = (const unsigned char*)slice->start;
+    input_end = input + slice->length;
+    output_end = output + size - 1;
+    while (input < input_end)
+    {
+        if (input[0] != '\\')
+        {
+            if (output >= output_end)
+            {
+                return false;
+            }
+            *output++ = *input++;
+            continue;
+        }
+
+        if ((input_end - input) < 2)
+        {
+            return false;
+        }
+        if (input[1] == 'u')
+        {
+            /* a code point takes at most 4 bytes of UTF-8 */
+            unsigned char sequence_length;
+            if ((output_end - output) < 4)
+            {
+                return false;
+            }
+            sequence_length = utf16_literal_to_utf8(input, input_end, &output);
+            if (sequence_length == 0)
+            {
+                return false;
+            }
+            input += sequence_length;
+            continue;
+        }
+
+        if (output >= output_end)
+        {
+            return false;
+        }
+        switch (input[1])
+        {
+            case 'b': *output++ = '\b'; break;
+            case 'f': *output++ = '\f'; break;
+            case 'n': *output++ = '\n'; break;
+            case 'r': *output++ = '\r'; break;
+            case 't': *output++ = '\t'; break;
+            case '\"':
+            case '\\':
+            case '/':
+                *output++ = input[1];
+                break;
+            default:
+                return false;
+        }
+        input += 2;
+    }
+
+    *output = '\0';
+    return true;
+}
+
+/* Push parsing of a top-level array: bytes arrive in arbitrary chunks, and every completed
+ * element is parsed on its own (in situ, into an arena) and handed to the callback. Only the
+ * element being received is buffered. */
+typedef enum
+{
+    stream_before_array,
+    stream_before_first_element,
+    stream_before_element,
+    stream_in_element,
+    stream_after_element,
+    stream_done,
+    stream_stopped,
+    stream_failed
+} stream_state;
+
+struct cJSON_Stream
+{
+    cJSON_StreamCallback callback;
+    void *user_data;
+    stream_state state;
+    unsigned char *element;
+    size_t length;
+    size_t capacity;
+    size_t depth;
+    cJSON_bool in_string;
+    cJSON_bool escaped;
+    cJSON_bool scalar;
+    size_t consumed;
+    size_t bom_bytes;
+    cJSON_Arena arena;
+};
+
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(cJSON_StreamCallback callback, void *user_data)
+{
+    cJSON_Stream *stream = NULL;
+
+    if (callback == NULL)
+    {
+        return NULL;
+    }
+
+    stream = (cJSON_Stream*)global_hooks.allocate(sizeof(cJSON_Stream));
+    if (stream == NULL)
+    {
+        return NULL;
+    }
+    memset(stream, 0, sizeof(cJSON_Stream));
+    stream->callback = callback;
+    stream->user_data = user_data;
+    stream->state = stream_before_array;
+    cJSON_InitArena(&stream->arena, NULL, 0, 0);
+
+    return stream;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream)
+{
+    if (stream == NULL)
+    {
+        return;
+    }
+    cJSON_FreeArena(&stream->arena);
+    if (stream->element != NULL)
+    {
+        global_hooks.deallocate(stream->element);
+    }
+    global_hooks.deallocate(stream);
+}
+
+static cJSON_bool stream_append(cJSON_Stream * const stream, const unsigned char *bytes, size_t length)
+{
+    if (length == 0)
+    {
+        return true;
+    }
+
+    if (length > (stream->capacity - stream->length))
+    {
+        size_t capacity = (stream->capacity > 0) ? stream->capacity : 256;
+        unsigned char *element = NULL;
+
+        while (capacity < (stream->length + length))
+        {
+            capacity *= 2;
+        }
+        element = (unsigned char*)global_hooks.allocate(capacity);
+        if (element == NULL)
+        {
+            return false;
+        }
+        if (stream->element != NULL)
+        {
+            memcpy(element, stream->element, stream->length);
+            global_hooks.deallocate(stream->element);
+        }
+        stream->element = element;
+        stream->capacity = capacity;
+    }
+
+    memcpy(stream->element + stream->length, bytes, length);
+    stream->length += length;
+    return true;
+}
+
+static stream_state stream_emit(cJSON_Stream * const stream)
+{
+    internal_hooks hooks = global_hooks;
+    const char *end = NULL;
+    cJSON *element = NULL;
+    cJSON_bool keep_going = false;
+
+    hooks.arena = &stream->arena;
+    element = parse_with_hooks((const char*)stream->element, stream->length, &end, false, &hooks, true);
+    /* the whole buffered text has to be one value */
+    if ((element == NULL) || (end != (const char*)stream->element + stream->length))
+    {
+        cJSON_ResetArena(&stream->arena);
+        return stream_failed;
+    }
+
+    keep_going = stream->callback(element, stream->user_data);
+    cJSON_ResetArena(&stream->arena);
+    stream->length = 0;
+    return keep_going ? stream_after_element : stream_stopped;
+}
+
+/* Consumes bytes of the element being received up to its end or the end of the chunk.
+ * Scalars end at the delimiter after them, which is left for the caller. */
+static size_t stream_element_bytes(cJSON_Stream * const stream, const unsigned char *chunk, size_t length, cJSON_bool *complete)
+{
+    size_t i = 0;
+
+    *complete = false;
+    while (i < length)
+    {
+        unsigned char c = chunk[i];
+        if (stream->in_string)
+        {
+            if (stream->escaped)
+            {
+                stream->escaped = false;
+                i++;
+                continue;
+            }
+            i += active_scanner->string_run(chunk + i, chunk + length);
+            if (i == length)
+            {
+                break;
+            }
+            if (chunk[i] == '\\')
+            {
+                stream->escaped = true;
+            }
+            else
+            {
+                stream->in_string = false;
+                if (stream->depth == 0)
+                {
+                    *complete = true;
+                    return i + 1;
+                }
+            }
+            i++;
+            continue;
+        }
+
+        if (stream->scalar)
+        {
+            if ((c <= 32) || (c == ',') || (c == ']') || (c == '}'))
+            {
+                *complete = true;
+                return i;
+            }
+            i++;
+            continue;
+        }
+
+        switch (c)
+        {
+            case '\"':
+                stream->in_string = true;
+                break;
+            case '{':
+            case '[':
+                stream->depth++;
+                break;
+            case '}':
+            case ']':
+                if (--stream->depth == 0)
+                {
+                    *complete = true;
+                    return i + 1;
+                }
+                break;
+            default:
+                break;
+        }
+        i++;
+    }
+
+    return i;
+}
+
+CJSON_PUBLIC(int) cJSON_StreamFeed(cJSON_Stream *stream, const char *chunk, size_t length)
+{
+    const unsigned char *bytes = (const unsigned char*)chunk;
+    size_t i = 0;
+
+    if ((stream == NULL) || ((chunk == NULL) && (length > 0)))
+    {
+        return -1;
+    }
+
+    while ((i < length) && (stream->state != stream_stopped) && (stream->state != stream_failed))
+    {
+        unsigned char c = bytes[i];
+        if ((stream->state != stream_in_element) && (c <= 32))
+        {
+            i++;
+            continue;
+        }
+
+        switch (stream->state)
+        {
+            case stream_before_array:
+                if ((stream->bom_bytes == stream->consumed + i) && (stream->bom_bytes < 3) && (c == (unsigned char)"\xEF\xBB\xBF"[stream->bom_bytes]))
+                {
+                    stream->bom_bytes++; /* UTF-8 byte order mark */
+                    i++;
+                }
+                else if ((c == '[') && ((stream->bom_bytes == 0) || (stream->bom_bytes == 3)))
+                {
+                    stream->state = stream_before_first_element;
+                    i++;
+                }
+                else
+                {
+                    stream->state = stream_failed;
+                }
+                break;
+
+            case stream_before_first_element:
+            case stream_before_element:
+                if ((c == ']') && (stream->state == stream_before_first_element))
+                {
+                    stream->state = stream_done;
+                    i++;
+                }
+                else if ((c == ']') || (c == ','))
+                {
+                    stream->state = stream_failed;
+                }
+                else
+                {
+                    stream->depth = 0;
+                    stream->in_string = false;
+                    stream->escaped = false;
+                    stream->scalar = (c != '{') && (c != '[') && (c != '\"');
+                    stream->state = stream_in_element;
+                }
+                break;
+
+            case stream_in_element:
+            {
+                cJSON_bool complete = false;
+                size_t used = stream_element_bytes(stream, bytes + i, length - i, &complete);
+                if (!stream_append(stream, bytes + i, used))
+                {
+                    stream->state = stream_failed;
+                    break;
+                }
+                i += used;
+                if (complete)
+                {
+                    stream->state = stream_emit(stream);
+                }
+                break;
+            }
+
+            case stream_after_element:
+                if (c == ',')
+                {
+                    stream->state = stream_before_element;
+                }
+                else if (c == ']')
+                {
+                    stream->state = stream_done;
+                }
+                else
+                {
+                    stream->state = stream_failed;
+                }
+                i++;
+                break;
+
+            default:
+                /* anything but whitespace after the array */
+                stream->state = stream_failed;
+                break;
+        }
+    }
+
+    stream->consumed += i;
+    if (stream->state == stream_failed)
+    {
+        return -1;
+    }
+    return (stream->state == stream_stopped) ? 1 : 0;
+}
+
+CJSON_PUBLIC(int) cJSON_StreamFinish(cJSON_Stream *stream)
+{
+    if (stream == NULL)
+    {
+        return -1;
+    }
+
+    switch (stream->state)
+    {
+        case stream_done:
+            return 0;
+        case stream_stopped:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item)
 {
     if (item == NULL)
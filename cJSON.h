@@ -120,6 +120,9 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Private hash index over an object's members, see CJSON_INDEX_THRESHOLD. */
+    struct cJSON_ObjectIndex *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -131,12 +134,37 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+typedef struct cJSON_ArenaBlock cJSON_ArenaBlock;
+
+/* Bump allocator for cJSON_ParseInArena. Every node and string of a parse is carved out of
+ * the caller's buffer first, then out of heap blocks of block_size bytes. Treat the fields as private. */
+typedef struct cJSON_Arena
+{
+    unsigned char *initial;
+    unsigned char *initial_limit;
+    cJSON_ArenaBlock *blocks;
+    cJSON_ArenaBlock *current;
+    unsigned char *cursor;
+    unsigned char *limit;
+    size_t block_size;
+} cJSON_Arena;
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* Parsed objects with at least this many members get a hash index, making
+ * cJSON_GetObjectItem and friends O(1) on them. On the heap it is built by the first lookup
+ * that walks past this many members, so lookups on one such object from several threads need
+ * a lock; in an arena it is built while parsing. Adding, detaching or replacing members drops
+ * the index (lookups go back to a linear scan); do not rename members by writing to ->string,
+ * or change an object's members through a reference to it, while it is indexed. */
+#ifndef CJSON_INDEX_THRESHOLD
+#define CJSON_INDEX_THRESHOLD 8
+#endif
+
 /* Limits the length of circular references can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_CIRCULAR_LIMIT
@@ -158,6 +186,22 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
 
+/* Arena parsing: the returned tree lives in the arena and is released all at once by cJSON_ResetArena
+ * (which keeps heap blocks for reuse) or cJSON_FreeArena. Never cJSON_Delete an arena tree, and do not
+ * attach items created by other cJSON functions to it. buffer may be NULL; block_size 0 picks a default. */
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t buffer_size, size_t block_size);
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+CJSON_PUBLIC(void) cJSON_FreeArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArena(cJSON_Arena *arena, const char *value);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthInArena(cJSON_Arena *arena, const char *value, size_t buffer_length);
+
+/* In-situ parsing: strings are unescaped inside value itself and every valuestring and key points
+ * into it (flagged cJSON_IsReference / cJSON_StringIsConst), so no string is allocated. value must
+ * stay alive and unmodified for as long as the tree (or any cJSON_Duplicate of it) is used, and is
+ * left modified even when parsing fails. Delete the tree with cJSON_Delete (or reset the arena). */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituInArena(cJSON_Arena *arena, char *value, size_t buffer_length);
+
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. */
@@ -265,6 +309,45 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
  * but should point to a readable and writable address area. */
 CJSON_PUBLIC(void) cJSON_Minify(char *json);
 
+/* Parsing and minifying skip runs of plain bytes with SIMD kernels ("avx2", "sse2") where the CPU
+ * has them, otherwise "scalar". cJSON_UseScanner() forces one, e.g. to compare against scalar,
+ * or "bytewise" for the original one-byte-at-a-time loops; it returns false if the CPU lacks it.
+ * Call it before parsing starts on any thread. */
+CJSON_PUBLIC(const char*) cJSON_GetScanner(void);
+CJSON_PUBLIC(cJSON_bool) cJSON_UseScanner(const char *name);
+
+/* On-demand extraction without building a tree. path is a sequence of member names and array
+ * selectors, e.g. "c", "quote.c", "[0]" or "[*].symbol"; "[*]" visits every element. Each match is
+ * handed to callback as a slice of the input, which returns false to stop scanning. Strings are
+ * sliced inside their quotes with escapes left encoded. Returns the number of matches or -1 if the
+ * scanned part of the document is malformed. Member names are compared without decoding escapes. */
+typedef struct cJSON_Slice
+{
+    int type;
+    const char *start;
+    size_t length;
+} cJSON_Slice;
+typedef cJSON_bool (*cJSON_SliceCallback)(const cJSON_Slice *slice, void *user_data);
+CJSON_PUBLIC(int) cJSON_ScanPath(const char *json, size_t length, const char *path, cJSON_SliceCallback callback, void *user_data);
+/* First match only; scanning stops as soon as it is found. */
+CJSON_PUBLIC(cJSON_bool) cJSON_FindPath(const char *json, size_t length, const char *path, cJSON_Slice *slice);
+CJSON_PUBLIC(cJSON_bool) cJSON_SliceToNumber(const cJSON_Slice *slice, double *number);
+/* Decodes escapes into buffer; fails if it does not fit in size bytes including the terminator. */
+CJSON_PUBLIC(cJSON_bool) cJSON_SliceToString(const cJSON_Slice *slice, char *buffer, size_t size);
+
+/* Push parsing of a top-level array, for bodies that arrive in chunks (e.g. from a curl write
+ * callback). Feed bytes as they come; each element is parsed as soon as its last byte arrives and
+ * passed to callback, which returns false to stop. The element tree is only valid during the
+ * callback. Memory is bounded by the largest element, not the whole document.
+ * cJSON_StreamFeed returns 0 to keep feeding, 1 once the callback stopped and -1 on malformed input;
+ * cJSON_StreamFinish returns 0 if the array was complete, 1 if stopped and -1 if truncated. */
+typedef struct cJSON_Stream cJSON_Stream;
+typedef cJSON_bool (*cJSON_StreamCallback)(cJSON *element, void *user_data);
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(cJSON_StreamCallback callback, void *user_data);
+CJSON_PUBLIC(int) cJSON_StreamFeed(cJSON_Stream *stream, const char *chunk, size_t length);
+CJSON_PUBLIC(int) cJSON_StreamFinish(cJSON_Stream *stream);
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream);
+
 /* Helper functions for creating and adding items to an object at the same time.
  * They return the added item or NULL on failure. */
 CJSON_PUBLIC(cJSON*) cJSON_AddNullToObject(cJSON * const object, const char * const name);
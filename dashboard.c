@@ -0,0 +1,299 @@
+#include "dashboard.h"
+#include "analytics.h"
+#include "database.h"
+#include "quote_cache.h"
+#include "latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <time.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#define DEFAULT_FPS 4
+#define RELOAD_SECONDS 5        /* positions are re-read from the database this often */
+#define CELL_LEN 24
+#define COLUMNS 7
+#define FIRST_ROW 3             /* below the title and the column headings */
+
+enum { PLAIN, GAIN, LOSS };
+
+static const struct {
+    const char *title;
+    int width;
+} columns[COLUMNS] = {
+    { "Symbol", 10 }, { "Quantity", 10 }, { "Price", 14 }, { "Value", 16 }, { "P/L", 16 }, { "Weight", 8 }, { "Day", 8 },
+};
+
+typedef struct {
+    char text[CELL_LEN];
+    int color;
+} cell;
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} frame_buffer;
+
+typedef struct {
+    position_buffers positions;
+    int screen_rows;
+    size_t shown;               /* positions that fit on screen */
+    cell *drawn;                /* what the terminal shows: shown rows, then the total row */
+    int full;                   /* next frame repaints everything */
+    unsigned long frames;
+    frame_buffer out;
+} dashboard;
+
+static void append(frame_buffer *out, const char *format, ...) {
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        size_t room = out->capacity - out->length;
+        int n = vsnprintf(out->data ? out->data + out->length : NULL, room, format, args);
+        va_end(args);
+        if (n < 0) return;
+        if ((size_t)n < room) {
+            out->length += (size_t)n;
+            return;
+        }
+        size_t capacity = out->capacity ? out->capacity * 2 : 4096;
+        while (capacity - out->length <= (size_t)n) capacity *= 2;
+        char *grown = realloc(out->data, capacity);
+        if (grown == NULL) return;
+        out->data = grown;
+        out->capacity = capacity;
+    }
+}
+
+static int column_x(int column) {
+    int x = 1;
+    for (int c = 0; c < column; c++) x += columns[c].width + 1;
+    return x;
+}
+
+static int terminal_rows(void) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) return size.ws_row;
+    return 24;
+}
+
+/* Same symbols in the same order: the layout stands and only cells can change. */
+static int same_layout(const position_buffers *a, const position_buffers *b) {
+    if (a->count != b->count) return 0;
+    for (size_t i = 0; i < a->count; i++) {
+        if (strcmp(a->symbol[i], b->symbol[i]) != 0) return 0;
+    }
+    return 1;
+}
+
+static int reload_positions(dashboard *d, int user_id) {
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+
+    position_buffers fresh;
+    if (init_position_buffers(&fresh, 0) != 0 || load_user_positions(db, user_id, &fresh) != 0) {
+        free_position_buffers(&fresh);
+        close_database(db);
+        return -1;
+    }
+    close_database(db);
+
+    if (!same_layout(&d->positions, &fresh)) d->full = 1;
+    free_position_buffers(&d->positions);
+    d->positions = fresh;
+    return 0;
+}
+
+static void set_cell(cell *c, int color, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(c->text, sizeof(c->text), format, args);
+    va_end(args);
+    c->color = color;
+}
+
+static int sign_color(double value) {
+    return value > 0 ? GAIN : (value < 0 ? LOSS : PLAIN);
+}
+
+/* Formats the cells of one frame into row-major `cells` (shown rows, then the total row). */
+static void format_cells(const dashboard *d, const portfolio_summary *total, cell *cells) {
+    const position_buffers *p = &d->positions;
+    char money_buf[MONEY_STR_LEN];
+    for (size_t i = 0; i < d->shown; i++) {
+        cell *row = cells + i * COLUMNS;
+        int priced = p->price[i] != 0;
+        set_cell(&row[0], PLAIN, "%s", p->symbol[i]);
+        set_cell(&row[1], PLAIN, "%lld", (long long)p->quantity[i]);
+        set_cell(&row[2], PLAIN, priced ? "$%s" : "-", money_format(p->price[i], money_buf));
+        set_cell(&row[3], PLAIN, priced ? "$%s" : "-", money_format(p->market_value[i], money_buf));
+        set_cell(&row[4], sign_color((double)p->unrealized_pl[i]), priced ? "$%s" : "-",
+                 money_format(p->unrealized_pl[i], money_buf));
+        set_cell(&row[5], PLAIN, "%.1f%%", 100.0 * p->weight[i]);
+        set_cell(&row[6], sign_color(p->daily_return[i]), priced ? "%+.2f%%" : "-", 100.0 * p->daily_return[i]);
+    }
+
+    cell *row = cells + d->shown * COLUMNS;
+    set_cell(&row[0], PLAIN, "Total");
+    set_cell(&row[1], PLAIN, "%zu", p->count);
+    set_cell(&row[2], PLAIN, "");
+    set_cell(&row[3], PLAIN, "$%s", money_format(total ? total->market_value : 0, money_buf));
+    set_cell(&row[4], sign_color(total ? (double)total->unrealized_pl : 0.0), "$%s",
+             money_format(total ? total->unrealized_pl : 0, money_buf));
+    set_cell(&row[5], PLAIN, "");
+    set_cell(&row[6], sign_color(total ? total->daily_return : 0.0), "%+.2f%%", total ? 100.0 * total->daily_return : 0.0);
+}
+
+static int screen_line(const dashboard *d, size_t row) {
+    /* the total row sits one blank line below the positions */
+    return FIRST_ROW + (int)row + (row == d->shown ? 1 : 0);
+}
+
+static void draw_frame(dashboard *d) {
+    position_buffers *p = &d->positions;
+    for (size_t i = 0; i < p->count; i++) {
+        stock_quote quote;
+        if (quote_cache_get(p->symbol[i], INT_MAX, &quote) == 0) {
+            p->price[i] = quote.current;
+            p->previous_close[i] = quote.previous_close;
+        } else {
+            p->price[i] = 0;
+            p->previous_close[i] = 0;
+        }
+    }
+    portfolio_summary *summary = NULL;
+    size_t summary_count = 0;
+    if (analyze_positions(p, &summary, &summary_count) != 0) return;
+
+    int rows = terminal_rows();
+    if (rows != d->screen_rows) d->full = 1;
+
+    frame_buffer *out = &d->out;
+    out->length = 0;
+    if (d->full) {
+        d->screen_rows = rows;
+        int room = rows - FIRST_ROW - 2;        /* blank line, total row, status line */
+        d->shown = room > 0 ? ((size_t)room < p->count ? (size_t)room : p->count) : 0;
+        free(d->drawn);
+        d->drawn = calloc((d->shown + 1) * COLUMNS, sizeof(cell));
+        if (d->drawn == NULL) {
+            free(summary);
+            return;
+        }
+        append(out, "\033[2J\033[H\033[36m=== Live Portfolio ===\033[0m\r\n\033[1m");
+        for (int c = 0; c < COLUMNS; c++) append(out, "%-*s ", columns[c].width, columns[c].title);
+        append(out, "\033[0m");
+    }
+
+    size_t cell_count = (d->shown + 1) * COLUMNS;
+    cell *cells = malloc(cell_count * sizeof(cell));
+    if (cells == NULL) {
+        free(summary);
+        return;
+    }
+    format_cells(d, summary_count ? &summary[0] : NULL, cells);
+
+    static const char *colors[] = { "", "\033[32m", "\033[31m" };
+    int changed = 0;
+    for (size_t i = 0; i < cell_count; i++) {
+        cell *now = &cells[i], *was = &d->drawn[i];
+        if (!d->full && now->color == was->color && strcmp(now->text, was->text) == 0) continue;
+        int column = (int)(i % COLUMNS);
+        append(out, "\033[%d;%dH%s%-*.*s%s", screen_line(d, i / COLUMNS), column_x(column), colors[now->color],
+               columns[column].width, columns[column].width, now->text, now->color ? "\033[0m" : "");
+        *was = *now;
+        changed++;
+    }
+    free(cells);
+    free(summary);
+
+    char clock[16];
+    time_t wall = time(NULL);
+    strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&wall));
+    d->frames++;
+    append(out, "\033[%d;1H\033[2K\033[2mUpdated %s, %d cells redrawn, frame %lu. Showing %zu of %zu.",
+           screen_line(d, d->shown) + 1, clock, changed, d->frames, d->shown, p->count);
+    unsigned long failures = quote_refresh_failures();
+    if (failures > 0) append(out, " %lu failed quote fetches.", failures);
+    append(out, " q to quit.\033[0m");
+
+    d->full = 0;
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t n = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+}
+
+int run_dashboard(int user_id) {
+    const char *env = getenv("STOCKSIM_DASHBOARD_FPS");
+    int fps = env != NULL && atoi(env) > 0 ? atoi(env) : DEFAULT_FPS;
+    double interval = 1.0 / fps;
+    int notify = quote_cache_subscribe();
+
+    dashboard d;
+    memset(&d, 0, sizeof(d));
+    if (reload_positions(&d, user_id) != 0) return -1;
+
+    struct termios saved;
+    int raw = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (raw) {
+        struct termios t = saved;
+        t.c_lflag &= ~(ICANON | ECHO);
+        t.c_cc[VMIN] = 1;
+        t.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &t);
+    }
+    fflush(stdout);
+    printf("\033[?25l");
+    fflush(stdout);
+
+    double last_frame = -1.0, last_load = latency_now() / 1e9;
+    int dirty = 1, quit = 0;
+    d.full = 1;
+    while (!quit) {
+        double now = latency_now() / 1e9;
+        if (now - last_load >= RELOAD_SECONDS) {
+            reload_positions(&d, user_id);
+            last_load = now;
+            dirty = 1;
+        }
+        if (dirty && now - last_frame >= interval) {
+            draw_frame(&d);
+            last_frame = now;
+            dirty = 0;
+        }
+
+        /* While a frame is pending, only a key can cut the wait short; quote updates coalesce into it. */
+        double until = dirty ? last_frame + interval : last_load + RELOAD_SECONDS;
+        int timeout = (int)((until - latency_now() / 1e9) * 1000.0) + 1;
+        struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { notify, POLLIN, 0 } };
+        int watched = (!dirty && notify >= 0) ? 2 : 1;
+        if (poll(fds, watched, timeout > 0 ? timeout : 0) <= 0) continue;
+
+        if (fds[0].revents) {
+            char key;
+            if (read(STDIN_FILENO, &key, 1) != 1 || key == 'q' || key == 'Q' || key == '\n' || key == 27) quit = 1;
+        }
+        if (watched == 2 && fds[1].revents) {
+            char drain[64];
+            while (read(notify, drain, sizeof(drain)) > 0) {}
+            dirty = 1;
+        }
+    }
+
+    printf("\033[%d;1H\033[?25h\n", screen_line(&d, d.shown) + 1);
+    fflush(stdout);
+    if (raw) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    free(d.drawn);
+    free(d.out.data);
+    free_position_buffers(&d.positions);
+    return 0;
+}
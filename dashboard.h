@@ -0,0 +1,14 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+/*
+ * Live portfolio view. Prices come from the quote cache (kept warm by the
+ * price refresher); the dashboard sleeps until the cache announces a new
+ * quote or a key is pressed, then redraws at most STOCKSIM_DASHBOARD_FPS
+ * (default 4) times a second. Only cells whose text changed are rewritten,
+ * each with one cursor move, and a frame goes out in a single write().
+ * Returns when q, Enter or Escape is pressed.
+ */
+int run_dashboard(int user_id);
+
+#endif
@@ -1,10 +1,21 @@
 #include "database.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #define RESET_COLOR "\033[0m"
 #define BOLD "\033[1m"
 #define CYAN "\033[36m"
 #include "api.h"
+#include "money.h"
+#include "trade.h"
+#include "analytics.h"
+#include "montecarlo.h"
+#include "timeseries.h"
+#include "quote_cache.h"
+#include "latency.h"
+#include <time.h>
+
+#define SCHEMA_VERSION 1
 
 int execute_sql(sqlite3 *db, const char *sql) {
     char *err_msg = 0;
@@ -17,21 +28,116 @@ int execute_sql(sqlite3 *db, const char *sql) {
     return SQLITE_OK;
 }
 
+static int get_user_version(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    int version = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, 0) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return version;
+}
+
+static int table_exists(sqlite3 *db, const char *name) {
+    sqlite3_stmt *stmt;
+    int exists = 0;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;", -1, &stmt, 0) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+        exists = (sqlite3_step(stmt) == SQLITE_ROW);
+        sqlite3_finalize(stmt);
+    }
+    return exists;
+}
+
+/* Version 0 databases stored money as REAL dollars; rebuild those tables with INTEGER micro-dollars. */
+static int migrate_money_columns(sqlite3 *db) {
+    const char *sql =
+        "BEGIN TRANSACTION;"
+
+        "CREATE TABLE users_v1 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "username TEXT NOT NULL UNIQUE,"
+        "password TEXT NOT NULL,"
+        "cash_balance INTEGER DEFAULT 10000000000,"
+        "total_portfolio_value INTEGER DEFAULT 0"
+        ");"
+        "INSERT INTO users_v1 (id, username, password, cash_balance, total_portfolio_value) "
+        "SELECT id, username, password, CAST(ROUND(cash_balance * 1000000) AS INTEGER), "
+        "CAST(ROUND(total_portfolio_value * 1000000) AS INTEGER) FROM users;"
+        "DROP TABLE users;"
+        "ALTER TABLE users_v1 RENAME TO users;"
+
+        "CREATE TABLE portfolio_v1 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "user_id INTEGER NOT NULL,"
+        "stock_symbol TEXT NOT NULL,"
+        "quantity INTEGER NOT NULL,"
+        "purchase_price INTEGER NOT NULL,"
+        "FOREIGN KEY (user_id) REFERENCES users(id)"
+        ");"
+        "INSERT INTO portfolio_v1 (id, user_id, stock_symbol, quantity, purchase_price) "
+        "SELECT id, user_id, stock_symbol, quantity, CAST(ROUND(purchase_price * 1000000) AS INTEGER) FROM portfolio;"
+        "DROP TABLE portfolio;"
+        "ALTER TABLE portfolio_v1 RENAME TO portfolio;"
+
+        "CREATE TABLE transactions_v1 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "user_id INTEGER NOT NULL,"
+        "stock_symbol TEXT NOT NULL,"
+        "transaction_type TEXT CHECK(transaction_type IN ('buy', 'sell')),"
+        "quantity INTEGER NOT NULL,"
+        "price INTEGER NOT NULL,"
+        "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "FOREIGN KEY (user_id) REFERENCES users(id)"
+        ");"
+        "INSERT INTO transactions_v1 (id, user_id, stock_symbol, transaction_type, quantity, price, timestamp) "
+        "SELECT id, user_id, stock_symbol, transaction_type, quantity, CAST(ROUND(price * 1000000) AS INTEGER), timestamp FROM transactions;"
+        "DROP TABLE transactions;"
+        "ALTER TABLE transactions_v1 RENAME TO transactions;"
+
+        "COMMIT;";
+
+    int rc = execute_sql(db, sql);
+    if (rc != SQLITE_OK) {
+        execute_sql(db, "ROLLBACK;");
+    }
+    return rc;
+}
+
+#define BUSY_TIMEOUT_MS 5000
+
+/* STOCKSIM_DB names another database file, e.g. a scratch one for load tests. */
+static const char *database_path(void) {
+    const char *path = getenv("STOCKSIM_DB");
+    return path != NULL && path[0] != '\0' ? path : "stock_simulator.db";
+}
+
 int initialize_database() {
     sqlite3 *db;
-    int rc = sqlite3_open("stock_simulator.db", &db);
+    int rc = sqlite3_open(database_path(), &db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
         return rc;
     }
 
+    if (get_user_version(db) == 0 && table_exists(db, "users") && table_exists(db, "portfolio") && table_exists(db, "transactions")) {
+        rc = migrate_money_columns(db);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Failed to migrate money columns.\n");
+            sqlite3_close(db);
+            return rc;
+        }
+    }
+
     const char *sql = 
         "CREATE TABLE IF NOT EXISTS users ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "username TEXT NOT NULL UNIQUE,"
         "password TEXT NOT NULL,"
-        "cash_balance REAL DEFAULT 10000.0,"
-        "total_portfolio_value REAL DEFAULT 0.0" 
+        "cash_balance INTEGER DEFAULT 10000000000,"
+        "total_portfolio_value INTEGER DEFAULT 0"
         ");"
 
         "CREATE TABLE IF NOT EXISTS portfolio ("
@@ -39,7 +145,7 @@ int initialize_database() {
         "user_id INTEGER NOT NULL,"
         "stock_symbol TEXT NOT NULL,"
         "quantity INTEGER NOT NULL,"
-        "purchase_price REAL NOT NULL,"
+        "purchase_price INTEGER NOT NULL,"
         "FOREIGN KEY (user_id) REFERENCES users(id)"
         ");"
 
@@ -49,7 +155,7 @@ int initialize_database() {
         "stock_symbol TEXT NOT NULL,"
         "transaction_type TEXT CHECK(transaction_type IN ('buy', 'sell')),"
         "quantity INTEGER NOT NULL,"
-        "price REAL NOT NULL,"
+        "price INTEGER NOT NULL,"
         "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,"
         "FOREIGN KEY (user_id) REFERENCES users(id)"
         ");"
@@ -58,6 +164,13 @@ int initialize_database() {
         "user_id INTEGER PRIMARY KEY,"
         "rank INTEGER,"
         "FOREIGN KEY (user_id) REFERENCES users(id)"
+        ");"
+
+        "CREATE TABLE IF NOT EXISTS watchlist ("
+        "user_id INTEGER NOT NULL,"
+        "stock_symbol TEXT NOT NULL,"
+        "PRIMARY KEY (user_id, stock_symbol),"
+        "FOREIGN KEY (user_id) REFERENCES users(id)"
         ");";
 
     rc = execute_sql(db, sql);
@@ -67,18 +180,30 @@ int initialize_database() {
         return rc;
     }
 
+    char version_sql[64];
+    snprintf(version_sql, sizeof(version_sql), "PRAGMA user_version = %d;", SCHEMA_VERSION);
+    execute_sql(db, version_sql);
+
+    /* readers no longer block the writer (or each other) when several sessions trade at once */
+    execute_sql(db, "PRAGMA journal_mode = WAL;");
+
     printf("Database initialized successfully.\n");
     sqlite3_close(db);
     return SQLITE_OK;
 }
 
 sqlite3* open_database() {
+    uint64_t start = latency_now();
     sqlite3 *db;
-    int rc = sqlite3_open("stock_simulator.db", &db);
+    int rc = sqlite3_open(database_path(), &db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
         return NULL;
     }
+    /* wait for a concurrent writer instead of failing with SQLITE_BUSY */
+    sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+    latency_record(LAT_DB_OPEN, start);
     return db;
 }
 
@@ -88,11 +213,14 @@ void close_database(sqlite3 *db) {
     }
 }
 
-int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
+/* Phases: open, read (the cash balance), write (up to COMMIT), commit. */
+static int place_buy(int user_id, const char *symbol, int quantity, money_t price) {
+    char money_buf[2][MONEY_STR_LEN];
+
+    uint64_t phase = latency_now();
     sqlite3 *db = open_database();
     if (!db) return -1;
-
-    double total_cost = quantity * price;
+    phase = latency_record(LAT_BUY_OPEN, phase);
 
     const char *cash_sql = "SELECT cash_balance FROM users WHERE id = ?;";
     sqlite3_stmt *stmt;
@@ -109,11 +237,20 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
         close_database(db);
         return -1;
     }
-    double cash_balance = sqlite3_column_double(stmt, 0);
+    money_t cash_balance = sqlite3_column_int64(stmt, 0);
     sqlite3_finalize(stmt);
+    phase = latency_record(LAT_BUY_READ, phase);
 
-    if (cash_balance < total_cost) {
-        printf("Insufficient funds. You have $%.2f but need $%.2f.\n", cash_balance, total_cost);
+    money_t total_cost;
+    int status = check_buy(cash_balance, quantity, price, &total_cost);
+    if (status == TRADE_INVALID_ORDER) {
+        printf("Invalid order: %d shares of %s.\n", quantity, symbol);
+        close_database(db);
+        return -1;
+    }
+    if (status == TRADE_INSUFFICIENT_FUNDS) {
+        printf("Insufficient funds. You have $%s but need $%s.\n",
+               money_format(cash_balance, money_buf[0]), money_format(total_cost, money_buf[1]));
         close_database(db);
         return -1;
     }
@@ -127,7 +264,7 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
         close_database(db);
         return -1;
     }
-    sqlite3_bind_double(stmt, 1, total_cost);
+    sqlite3_bind_int64(stmt, 1, total_cost);
     sqlite3_bind_int(stmt, 2, user_id);
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         fprintf(stderr, "Failed to update cash balance: %s\n", sqlite3_errmsg(db));
@@ -149,11 +286,10 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
     sqlite3_bind_text(stmt, 2, symbol, -1, SQLITE_TRANSIENT);
     rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
-        int existing_quantity = sqlite3_column_int(stmt, 0);
-        double existing_price = sqlite3_column_double(stmt, 1);
+        holding position = { sqlite3_column_int(stmt, 0), sqlite3_column_int64(stmt, 1) };
         sqlite3_finalize(stmt);
 
-        double new_average_price = ((existing_quantity * existing_price) + (quantity * price)) / (existing_quantity + quantity);
+        apply_buy(&position, quantity, price);
 
         const char *update_portfolio_sql = "UPDATE portfolio SET quantity = ?, purchase_price = ? WHERE user_id = ? AND stock_symbol = ?;";
         if (sqlite3_prepare_v2(db, update_portfolio_sql, -1, &stmt, 0) != SQLITE_OK) {
@@ -162,8 +298,8 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
             close_database(db);
             return -1;
         }
-        sqlite3_bind_int(stmt, 1, existing_quantity + quantity);
-        sqlite3_bind_double(stmt, 2, new_average_price);
+        sqlite3_bind_int(stmt, 1, position.quantity);
+        sqlite3_bind_int64(stmt, 2, position.average_price);
         sqlite3_bind_int(stmt, 3, user_id);
         sqlite3_bind_text(stmt, 4, symbol, -1, SQLITE_TRANSIENT);
         if (sqlite3_step(stmt) != SQLITE_DONE) {
@@ -187,7 +323,7 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
         sqlite3_bind_int(stmt, 1, user_id);
         sqlite3_bind_text(stmt, 2, symbol, -1, SQLITE_TRANSIENT);
         sqlite3_bind_int(stmt, 3, quantity);
-        sqlite3_bind_double(stmt, 4, price);
+        sqlite3_bind_int64(stmt, 4, price);
 
         if (sqlite3_step(stmt) != SQLITE_DONE) {
             fprintf(stderr, "Failed to insert into portfolio: %s\n", sqlite3_errmsg(db));
@@ -210,7 +346,7 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
     sqlite3_bind_text(stmt, 2, symbol, -1, SQLITE_TRANSIENT); 
     sqlite3_bind_text(stmt, 3, "buy", -1, SQLITE_STATIC);  
     sqlite3_bind_int(stmt, 4, quantity);          
-    sqlite3_bind_double(stmt, 5, price);         
+    sqlite3_bind_int64(stmt, 5, price);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         fprintf(stderr, "Failed to insert transaction: %s\n", sqlite3_errmsg(db));
@@ -241,16 +377,23 @@ int buy_stocks(int user_id, const char *symbol, int quantity, double price) {
     }
     sqlite3_finalize(stmt);
 
+    phase = latency_record(LAT_BUY_WRITE, phase);
     execute_sql(db, "COMMIT;");
+    latency_record(LAT_BUY_COMMIT, phase);
 
-    printf("Bought %d shares of %s at $%.2f each. Total cost: $%.2f\n", quantity, symbol, price, total_cost);
+    printf("Bought %d shares of %s at $%s each. Total cost: $%s\n", quantity, symbol,
+           money_format(price, money_buf[0]), money_format(total_cost, money_buf[1]));
     close_database(db);
     return 0;
 }
 
-int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
+static int place_sell(int user_id, const char *symbol, int quantity, money_t price) {
+    char money_buf[2][MONEY_STR_LEN];
+
+    uint64_t phase = latency_now();
     sqlite3 *db = open_database();
     if (!db) return -1;
+    phase = latency_record(LAT_SELL_OPEN, phase);
 
     const char *portfolio_sql = "SELECT quantity FROM portfolio WHERE user_id = ? AND stock_symbol = ?;";
     sqlite3_stmt *stmt;
@@ -270,15 +413,21 @@ int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
     }
     int owned_quantity = sqlite3_column_int(stmt, 0);
     sqlite3_finalize(stmt);
+    phase = latency_record(LAT_SELL_READ, phase);
 
-    if (owned_quantity < quantity) {
+    money_t total_revenue;
+    int status = check_sell(owned_quantity, quantity, price, &total_revenue);
+    if (status == TRADE_INVALID_ORDER) {
+        printf("Invalid order: %d shares of %s.\n", quantity, symbol);
+        close_database(db);
+        return -1;
+    }
+    if (status == TRADE_INSUFFICIENT_SHARES) {
         printf("Insufficient shares. You own %d shares of %s.\n", owned_quantity, symbol);
         close_database(db);
         return -1;
     }
 
-    double total_revenue = quantity * price;
-
     execute_sql(db, "BEGIN TRANSACTION;");
 
     const char *update_cash_sql = "UPDATE users SET cash_balance = cash_balance + ? WHERE id = ?;";
@@ -288,7 +437,7 @@ int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
         close_database(db);
         return -1;
     }
-    sqlite3_bind_double(stmt, 1, total_revenue);
+    sqlite3_bind_int64(stmt, 1, total_revenue);
     sqlite3_bind_int(stmt, 2, user_id);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
@@ -354,7 +503,7 @@ int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
     sqlite3_bind_text(stmt, 2, symbol, -1, SQLITE_TRANSIENT); 
     sqlite3_bind_text(stmt, 3, "sell", -1, SQLITE_STATIC);   
     sqlite3_bind_int(stmt, 4, quantity);          
-    sqlite3_bind_double(stmt, 5, price);
+    sqlite3_bind_int64(stmt, 5, price);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         fprintf(stderr, "Failed to insert transaction: %s\n", sqlite3_errmsg(db));
@@ -374,7 +523,7 @@ int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
     }
     sqlite3_bind_int(stmt, 1, user_id);
     rc = sqlite3_step(stmt);
-    double total_portfolio_value = (rc == SQLITE_ROW) ? sqlite3_column_double(stmt, 0) : 0.0;
+    money_t total_portfolio_value = (rc == SQLITE_ROW) ? sqlite3_column_int64(stmt, 0) : 0;
     sqlite3_finalize(stmt);
 
     const char *update_total_value_sql = "UPDATE users SET total_portfolio_value = ? WHERE id = ?;";
@@ -384,7 +533,7 @@ int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
         close_database(db);
         return -1;
     }
-    sqlite3_bind_double(stmt, 1, total_portfolio_value);
+    sqlite3_bind_int64(stmt, 1, total_portfolio_value);
     sqlite3_bind_int(stmt, 2, user_id);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
@@ -396,62 +545,139 @@ int sell_stocks(int user_id, const char *symbol, int quantity, double price) {
     }
     sqlite3_finalize(stmt);
 
+    phase = latency_record(LAT_SELL_WRITE, phase);
     execute_sql(db, "COMMIT;");
+    latency_record(LAT_SELL_COMMIT, phase);
 
-    printf("Sold %d shares of %s at $%.2f each. Total revenue: $%.2f\n", quantity, symbol, price, total_revenue);
+    printf("Sold %d shares of %s at $%s each. Total revenue: $%s\n", quantity, symbol,
+           money_format(price, money_buf[0]), money_format(total_revenue, money_buf[1]));
     close_database(db);
     return 0;
 }
 
-int view_portfolio(int user_id) {
+int buy_stocks(int user_id, const char *symbol, int quantity, money_t price) {
+    uint64_t start = latency_now();
+    int rc = place_buy(user_id, symbol, quantity, price);
+    latency_record(LAT_DB_BUY, start);
+    return rc;
+}
+
+int sell_stocks(int user_id, const char *symbol, int quantity, money_t price) {
+    uint64_t start = latency_now();
+    int rc = place_sell(user_id, symbol, quantity, price);
+    latency_record(LAT_DB_SELL, start);
+    return rc;
+}
+
+static int show_portfolio(int user_id) {
     sqlite3 *db = open_database();
     if (!db) return -1;
 
-    const char *sql = "SELECT stock_symbol, quantity, purchase_price FROM portfolio WHERE user_id = ?;";
-    sqlite3_stmt *stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare portfolio query: %s\n", sqlite3_errmsg(db));
+    position_buffers positions;
+    if (init_position_buffers(&positions, 0) != 0 || load_user_positions(db, user_id, &positions) != 0) {
+        free_position_buffers(&positions);
         close_database(db);
         return -1;
     }
+    close_database(db);
 
-    sqlite3_bind_int(stmt, 1, user_id);
+    load_position_quotes(&positions);
+
+    portfolio_summary *summary = NULL;
+    size_t summary_count = 0;
+    if (analyze_positions(&positions, &summary, &summary_count) != 0) {
+        free_position_buffers(&positions);
+        return -1;
+    }
 
     printf("\n=== Your Portfolio ===\n");
-    printf("%-10s %-10s %-15s %-15s %-15s\n", "Symbol", "Quantity", "Purchase Price", "Current Price", "P/L");
+    printf("%-10s %-10s %-15s %-15s %-15s %-8s %-8s\n", "Symbol", "Quantity", "Purchase Price", "Current Price", "P/L", "Weight", "Day");
+
+    char money_buf[3][MONEY_STR_LEN];
+    for (size_t i = 0; i < positions.count; i++) {
+        char weight_buf[16], day_buf[16];
+        snprintf(weight_buf, sizeof(weight_buf), "%.1f%%", 100.0 * positions.weight[i]);
+        snprintf(day_buf, sizeof(day_buf), "%+.2f%%", 100.0 * positions.daily_return[i]);
+        printf("%-10s %-10lld $%-14s $%-14s $%-14s %-8s %-8s\n", positions.symbol[i], (long long)positions.quantity[i],
+               money_format(positions.cost[i], money_buf[0]), money_format(positions.price[i], money_buf[1]),
+               money_format(positions.unrealized_pl[i], money_buf[2]), weight_buf, day_buf);
+    }
+
+    money_t total_current = summary_count ? summary[0].market_value : 0;
+    money_t total_pl = summary_count ? summary[0].unrealized_pl : 0;
+
+    printf("\nTotal Portfolio Value: $%s\n", money_format(total_current, money_buf[0]));
+    printf("Total Profit/Loss: $%s\n", money_format(total_pl, money_buf[0]));
+    if (summary_count) {
+        printf("Day Change: %+.2f%%\n", 100.0 * summary[0].daily_return);
+        double volatility = portfolio_volatility(&positions, 0, positions.count, 90);
+        if (volatility > 0.0) {
+            printf("Annualized Volatility (90d): %.2f%%\n", 100.0 * volatility);
+        }
+    }
 
-    double total_cost = 0.0;
-    double total_current = 0.0;
+    free(summary);
+    free_position_buffers(&positions);
+    return 0;
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const unsigned char *symbol = sqlite3_column_text(stmt, 0);
-        int quantity = sqlite3_column_int(stmt, 1);
-        double purchase_price = sqlite3_column_double(stmt, 2);
+static int show_portfolio_risk(int user_id) {
+    sqlite3 *db = open_database();
+    if (!db) return -1;
 
-        double current_price;
-        if (fetch_stock_price((const char*)symbol, &current_price) != 0) {
-            current_price = 0.0;
-        }
+    position_buffers positions;
+    if (init_position_buffers(&positions, 0) != 0 || load_user_positions(db, user_id, &positions) != 0) {
+        free_position_buffers(&positions);
+        close_database(db);
+        return -1;
+    }
+    close_database(db);
+
+    if (positions.count == 0) {
+        printf("You have no positions to analyze.\n");
+        free_position_buffers(&positions);
+        return 0;
+    }
 
-        double pl = (current_price - purchase_price) * quantity;
-        total_cost += purchase_price * quantity;
-        total_current += current_price * quantity;
+    risk_config config;
+    default_risk_config(&config);
 
-        printf("%-10s %-10d $%-14.2f $%-14.2f $%-14.2f\n", symbol, quantity, purchase_price, current_price, pl);
+    int64_t now = (int64_t)time(NULL);
+    for (size_t i = 0; i < positions.count; i++) {
+        ingest_candles(positions.symbol[i], "D", now - (int64_t)(config.history_days + 7) * 86400, now);
     }
+    load_position_quotes(&positions);
 
-    double total_pl = total_current - total_cost;
+    printf("\n%s=== Portfolio Risk (Monte Carlo) ===%s\n", CYAN, RESET_COLOR);
+    printf("%-10s %-15s %-15s %-15s %-10s\n", "Horizon", "Value", "VaR", "Exp. Shortfall", "Paths");
 
-    printf("\nTotal Portfolio Value: $%.2f\n", total_current);
-    printf("Total Profit/Loss: $%.2f\n", total_pl);
+    const int horizons[] = { 1, 10 };
+    for (size_t h = 0; h < sizeof(horizons) / sizeof(horizons[0]); h++) {
+        risk_report report;
+        config.horizon_days = horizons[h];
+        if (simulate_portfolio_risk(&positions, 0, positions.count, &config, &report) != 0) {
+            fprintf(stderr, "Risk simulation failed.\n");
+            free_position_buffers(&positions);
+            return -1;
+        }
+        char money_buf[3][MONEY_STR_LEN], horizon_buf[16];
+        snprintf(horizon_buf, sizeof(horizon_buf), "%d day%s", horizons[h], horizons[h] == 1 ? "" : "s");
+        printf("%-10s $%-14s $%-14s $%-14s %-10zu (%.2fs)\n", horizon_buf, money_format(report.value, money_buf[0]),
+               money_format(report.value_at_risk, money_buf[1]), money_format(report.expected_shortfall, money_buf[2]),
+               report.paths, report.seconds);
+        if (h == 0 && report.symbols_with_history < positions.count) {
+            printf("Note: %zu of %zu holdings lack price history and use a flat %.0f%% daily volatility.\n",
+                   positions.count - report.symbols_with_history, positions.count,
+                   100.0 * FALLBACK_DAILY_VOLATILITY);
+        }
+    }
+    printf("VaR and expected shortfall are %.0f%% one-tailed losses.\n", 100.0 * config.confidence);
 
-    sqlite3_finalize(stmt);
-    close_database(db);
+    free_position_buffers(&positions);
     return 0;
 }
 
-int view_transactions(int user_id) {
+static int show_transactions(int user_id) {
     sqlite3 *db = open_database();
     if (!db) return -1;
 
@@ -473,10 +699,11 @@ int view_transactions(int user_id) {
         const unsigned char *type = sqlite3_column_text(stmt, 0);
         const unsigned char *symbol = sqlite3_column_text(stmt, 1);
         int quantity = sqlite3_column_int(stmt, 2);
-        double price = sqlite3_column_double(stmt, 3);
+        money_t price = sqlite3_column_int64(stmt, 3);
         const unsigned char *timestamp = sqlite3_column_text(stmt, 4);
+        char price_buf[MONEY_STR_LEN];
 
-        printf("%-10s %-10s %-10d $%-9.2f %-20s\n", type, symbol, quantity, price, timestamp);
+        printf("%-10s %-10s %-10d $%-9s %-20s\n", type, symbol, quantity, money_format(price, price_buf), timestamp);
     }
 
     sqlite3_finalize(stmt);
@@ -484,43 +711,115 @@ int view_transactions(int user_id) {
     return 0;
 }
 
-int view_leaderboard() {
-    sqlite3 *db = open_database();
-    if (!db) return 0;
+typedef struct {
+    int user_id;
+    char username[64];
+    money_t cash;
+    money_t net_worth;
+} leaderboard_entry;
 
-    const char *sql = 
-        "SELECT users.username, users.cash_balance, users.total_portfolio_value, "
-        "(users.cash_balance + users.total_portfolio_value) AS net_worth "
-        "FROM users "
-        "ORDER BY net_worth DESC "
-        "LIMIT 10;";
+static int compare_net_worth(const void *a, const void *b) {
+    money_t x = ((const leaderboard_entry *)a)->net_worth, y = ((const leaderboard_entry *)b)->net_worth;
+    return (x < y) - (x > y);
+}
 
+static int load_leaderboard_users(sqlite3 *db, leaderboard_entry **entries, size_t *count) {
     sqlite3_stmt *stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db, "SELECT id, username, cash_balance FROM users ORDER BY id;", -1, &stmt, 0) != SQLITE_OK) {
         fprintf(stderr, "Failed to prepare leaderboard query: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+
+    leaderboard_entry *out = NULL;
+    size_t n = 0, capacity = 0;
+    int rc = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            leaderboard_entry *grown = realloc(out, capacity * sizeof(*out));
+            if (grown == NULL) {
+                rc = -1;
+                break;
+            }
+            out = grown;
+        }
+        out[n].user_id = sqlite3_column_int(stmt, 0);
+        snprintf(out[n].username, sizeof(out[n].username), "%s", (const char *)sqlite3_column_text(stmt, 1));
+        out[n].cash = sqlite3_column_int64(stmt, 2);
+        out[n].net_worth = out[n].cash;
+        n++;
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc != 0) {
+        fprintf(stderr, "Out of memory loading the leaderboard.\n");
+        free(out);
+        return -1;
+    }
+    *entries = out;
+    *count = n;
+    return 0;
+}
+
+/* Net worth is cash plus every holding at its current quote, so it is never staler than the quote cache. */
+static int show_leaderboard(void) {
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+
+    leaderboard_entry *entries = NULL;
+    size_t entry_count = 0;
+    position_buffers positions;
+    if (load_leaderboard_users(db, &entries, &entry_count) != 0) {
         close_database(db);
-        return 0;
+        return -1;
     }
+    if (init_position_buffers(&positions, 0) != 0 || load_all_positions(db, &positions) != 0) {
+        free_position_buffers(&positions);
+        free(entries);
+        close_database(db);
+        return -1;
+    }
+    close_database(db);
+
+    load_position_quotes(&positions);
+    for (size_t i = 0; i < positions.count; i++) {
+        if (positions.price[i] == 0) positions.price[i] = positions.cost[i];     /* unpriced: value at cost */
+    }
+
+    portfolio_summary *summary = NULL;
+    size_t summary_count = 0;
+    if (analyze_positions(&positions, &summary, &summary_count) != 0) {
+        free_position_buffers(&positions);
+        free(entries);
+        return -1;
+    }
+
+    /* both lists are in user_id order */
+    size_t e = 0;
+    for (size_t u = 0; u < summary_count; u++) {
+        while (e < entry_count && entries[e].user_id < summary[u].user_id) e++;
+        if (e < entry_count && entries[e].user_id == summary[u].user_id) {
+            entries[e].net_worth += summary[u].market_value;
+        }
+    }
+    qsort(entries, entry_count, sizeof(*entries), compare_net_worth);
 
     printf("\n%s=== Leaderboard ===%s\n", CYAN, RESET_COLOR);
     printf("%s%-4s   %-12s %-10s  %-12s%s\n", BOLD, "RANK", "USERNAME", "BALANCE", "NET WORTH", RESET_COLOR);
 
-    int rank = 1;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const unsigned char *username = sqlite3_column_text(stmt, 0);
-        double cash_balance = sqlite3_column_double(stmt, 1);
-        double total_portfolio_value = sqlite3_column_double(stmt, 2);
-
-        printf("%-4d   %-12s $%-10.2f $%-12.2f\n", rank++, username, cash_balance, total_portfolio_value);
+    for (size_t i = 0; i < entry_count && i < 10; i++) {
+        char money_buf[2][MONEY_STR_LEN];
+        printf("%-4zu   %-12s $%-10s $%-12s\n", i + 1, entries[i].username, money_format(entries[i].cash, money_buf[0]),
+               money_format(entries[i].net_worth, money_buf[1]));
     }
 
-    sqlite3_finalize(stmt);
-    close_database(db);
+    free(summary);
+    free_position_buffers(&positions);
+    free(entries);
     return 0;
 }
 
-int view_user_details(int user_id) {
+static int show_user_details(int user_id) {
     sqlite3 *db = open_database();
     if (!db) return 0;
 
@@ -545,17 +844,18 @@ int view_user_details(int user_id) {
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         const char *username = (const char *)sqlite3_column_text(stmt, 0);
-        double cash_balance = sqlite3_column_double(stmt, 1);
-        double total_portfolio_value = sqlite3_column_double(stmt, 2);
-        double net_worth = sqlite3_column_double(stmt, 3);
+        money_t cash_balance = sqlite3_column_int64(stmt, 1);
+        money_t total_portfolio_value = sqlite3_column_int64(stmt, 2);
+        money_t net_worth = sqlite3_column_int64(stmt, 3);
+        char money_buf[MONEY_STR_LEN];
 
         printf("\n-------------------------------------------\n");
         printf("           User Details                   \n");
         printf("-------------------------------------------\n");
         printf(" Username               : %s\n", username);
-        printf(" Cash Balance           : $%.2f\n", cash_balance);
-        printf(" Total Portfolio Value  : $%.2f\n", total_portfolio_value);
-        printf(" Net Worth              : $%.2f\n", net_worth);
+        printf(" Cash Balance           : $%s\n", money_format(cash_balance, money_buf));
+        printf(" Total Portfolio Value  : $%s\n", money_format(total_portfolio_value, money_buf));
+        printf(" Net Worth              : $%s\n", money_format(net_worth, money_buf));
         printf("-------------------------------------------\n\n");
     } else {
         printf("\nNo user found with the given ID: %d\n", user_id);
@@ -567,3 +867,117 @@ int view_user_details(int user_id) {
     return 0;
 }
 
+
+static int change_watchlist(int user_id, const char *symbol, const char *sql) {
+    if (symbol[0] == '\0' || strlen(symbol) >= SYMBOL_LEN) {
+        printf("Invalid symbol.\n");
+        return -1;
+    }
+
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare watchlist update: %s\n", sqlite3_errmsg(db));
+        close_database(db);
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_text(stmt, 2, symbol, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+    if (rc != 0) fprintf(stderr, "Failed to update watchlist: %s\n", sqlite3_errmsg(db));
+    sqlite3_finalize(stmt);
+    close_database(db);
+    return rc;
+}
+
+int add_to_watchlist(int user_id, const char *symbol) {
+    uint64_t start = latency_now();
+    int rc = change_watchlist(user_id, symbol, "INSERT OR IGNORE INTO watchlist (user_id, stock_symbol) VALUES (?, ?);");
+    latency_record(LAT_DB_WATCHLIST_EDIT, start);
+    if (rc == 0) printf("Watching %s.\n", symbol);
+    return rc;
+}
+
+int remove_from_watchlist(int user_id, const char *symbol) {
+    uint64_t start = latency_now();
+    int rc = change_watchlist(user_id, symbol, "DELETE FROM watchlist WHERE user_id = ? AND stock_symbol = ?;");
+    latency_record(LAT_DB_WATCHLIST_EDIT, start);
+    if (rc == 0) printf("Stopped watching %s.\n", symbol);
+    return rc;
+}
+
+static int show_watchlist(int user_id) {
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT stock_symbol FROM watchlist WHERE user_id = ? ORDER BY stock_symbol;", -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare watchlist query: %s\n", sqlite3_errmsg(db));
+        close_database(db);
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, user_id);
+
+    printf("\n%s=== Watchlist ===%s\n", CYAN, RESET_COLOR);
+    printf("%-10s %-15s %-8s\n", "Symbol", "Price", "Day");
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *symbol = (const char *)sqlite3_column_text(stmt, 0);
+        stock_quote quote;
+        char price_buf[MONEY_STR_LEN], day_buf[16];
+        if (cached_stock_quote(symbol, &quote) != 0) {
+            printf("%-10s %-15s\n", symbol, "unavailable");
+            continue;
+        }
+        double previous = (double)quote.previous_close;
+        snprintf(day_buf, sizeof(day_buf), "%+.2f%%", previous > 0.0 ? 100.0 * ((double)quote.current / previous - 1.0) : 0.0);
+        printf("%-10s $%-14s %-8s\n", symbol, money_format(quote.current, price_buf), day_buf);
+    }
+
+    sqlite3_finalize(stmt);
+    close_database(db);
+    return 0;
+}
+
+int view_portfolio(int user_id) {
+    uint64_t start = latency_now();
+    int rc = show_portfolio(user_id);
+    latency_record(LAT_DB_PORTFOLIO, start);
+    return rc;
+}
+
+int view_portfolio_risk(int user_id) {
+    uint64_t start = latency_now();
+    int rc = show_portfolio_risk(user_id);
+    latency_record(LAT_DB_RISK, start);
+    return rc;
+}
+
+int view_transactions(int user_id) {
+    uint64_t start = latency_now();
+    int rc = show_transactions(user_id);
+    latency_record(LAT_DB_TRANSACTIONS, start);
+    return rc;
+}
+
+int view_leaderboard() {
+    uint64_t start = latency_now();
+    int rc = show_leaderboard();
+    latency_record(LAT_DB_LEADERBOARD, start);
+    return rc;
+}
+
+int view_user_details(int user_id) {
+    uint64_t start = latency_now();
+    int rc = show_user_details(user_id);
+    latency_record(LAT_DB_PROFILE, start);
+    return rc;
+}
+
+int view_watchlist(int user_id) {
+    uint64_t start = latency_now();
+    int rc = show_watchlist(user_id);
+    latency_record(LAT_DB_WATCHLIST, start);
+    return rc;
+}
@@ -2,6 +2,7 @@
 #define DATABASE_H
 
 #include <sqlite3.h>
+#include "money.h"
 
 int initialize_database();
 
@@ -9,15 +10,23 @@ sqlite3* open_database();
 
 void close_database(sqlite3 *db);
 
+int execute_sql(sqlite3 *db, const char *sql);
+
 int signup(const char *username, const char *password);
 int login(const char *username, const char *password, int *user_id);
 
-int buy_stocks(int user_id, const char *symbol, int quantity, double price);
-int sell_stocks(int user_id, const char *symbol, int quantity, double price);
+int buy_stocks(int user_id, const char *symbol, int quantity, money_t price);
+int sell_stocks(int user_id, const char *symbol, int quantity, money_t price);
 
 int view_portfolio(int user_id);
+int view_portfolio_risk(int user_id);
 
 int view_transactions(int user_id);
+int view_user_details(int user_id);
+
+int add_to_watchlist(int user_id, const char *symbol);
+int remove_from_watchlist(int user_id, const char *symbol);
+int view_watchlist(int user_id);
 
 
 int update_leaderboard(int user_id);
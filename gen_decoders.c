@@ -0,0 +1,262 @@
+// gen_decoders.c
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Build-time generator: reads a schema of JSON payloads (see finnhub.schema) and
+ * writes <stem>.h and <stem>.c with a fixed struct and a direct decoder per
+ * payload on top of json_decode.h. Member names are matched on the raw key text
+ * (length first, then bytes), so unknown members are skipped without decoding.
+ * As with cJSON_GetObjectItem, the first of duplicate members wins.
+ *
+ *   gen_decoders finnhub.schema finnhub_decoders
+ */
+#define MAX_STRUCTS 32
+#define MAX_FIELDS 32
+#define NAME_LEN 64
+
+typedef enum { FIELD_MONEY, FIELD_DOUBLE, FIELD_INT64, FIELD_MONEY_ARRAY, FIELD_DOUBLE_ARRAY, FIELD_INT64_ARRAY, FIELD_STRING } field_type;
+
+typedef struct {
+    char key[NAME_LEN];
+    char name[NAME_LEN];
+    field_type type;
+    int size;
+} field_spec;
+
+typedef struct {
+    char name[NAME_LEN];
+    field_spec fields[MAX_FIELDS];
+    int field_count;
+} struct_spec;
+
+static struct_spec structs[MAX_STRUCTS];
+static int struct_count;
+
+static const struct {
+    const char *name;
+    field_type type;
+    const char *c_type;
+    const char *reader;
+} type_table[] = {
+    { "money", FIELD_MONEY, "money_t", "json_read_money" },
+    { "double", FIELD_DOUBLE, "double", "json_read_double" },
+    { "int64", FIELD_INT64, "int64_t", "json_read_int64" },
+    { "money[]", FIELD_MONEY_ARRAY, "money_t", "json_read_money_array" },
+    { "double[]", FIELD_DOUBLE_ARRAY, "double", "json_read_double_array" },
+    { "int64[]", FIELD_INT64_ARRAY, "int64_t", "json_read_int64_array" },
+    { "string", FIELD_STRING, "char", "json_read_string" },
+};
+
+static int is_array(field_type type) {
+    return type == FIELD_MONEY_ARRAY || type == FIELD_DOUBLE_ARRAY || type == FIELD_INT64_ARRAY;
+}
+
+static void upper(const char *in, char *out) {
+    for (; *in; in++) *out++ = (char)toupper((unsigned char)*in);
+    *out = '\0';
+}
+
+static int parse_schema(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open schema %s\n", path);
+        return -1;
+    }
+
+    char line[512];
+    int line_number = 0;
+    struct_spec *current = NULL;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char words[4][NAME_LEN];
+        int count = sscanf(line, "%63s %63s %63s %63s", words[0], words[1], words[2], words[3]);
+        if (count <= 0) continue;
+
+        if (strcmp(words[0], "struct") == 0 && count == 2 && current == NULL && struct_count < MAX_STRUCTS) {
+            current = &structs[struct_count++];
+            snprintf(current->name, sizeof(current->name), "%s", words[1]);
+            continue;
+        }
+        if (strcmp(words[0], "end") == 0 && count == 1 && current != NULL) {
+            current = NULL;
+            continue;
+        }
+        if (current == NULL || count < 3 || current->field_count == MAX_FIELDS) {
+            fprintf(stderr, "%s:%d: unexpected line\n", path, line_number);
+            fclose(file);
+            return -1;
+        }
+
+        field_spec *field = &current->fields[current->field_count++];
+        snprintf(field->key, sizeof(field->key), "%s", words[0]);
+        snprintf(field->name, sizeof(field->name), "%s", words[1]);
+        size_t t = 0;
+        while (t < sizeof(type_table) / sizeof(type_table[0]) && strcmp(type_table[t].name, words[2]) != 0) t++;
+        if (t == sizeof(type_table) / sizeof(type_table[0])) {
+            fprintf(stderr, "%s:%d: unknown type %s\n", path, line_number, words[2]);
+            fclose(file);
+            return -1;
+        }
+        field->type = type_table[t].type;
+        field->size = 0;
+        if (field->type == FIELD_STRING && (count != 4 || (field->size = atoi(words[3])) <= 1)) {
+            fprintf(stderr, "%s:%d: string needs a buffer size\n", path, line_number);
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+
+    if (current != NULL) {
+        fprintf(stderr, "%s: missing end for struct %s\n", path, current->name);
+        return -1;
+    }
+    return 0;
+}
+
+static void write_header(FILE *out, const char *schema, const char *stem) {
+    char guard[NAME_LEN * 2];
+    upper(stem, guard);
+
+    fprintf(out, "/* Generated by gen_decoders from %s. Do not edit. */\n", schema);
+    fprintf(out, "#ifndef %s_H\n#define %s_H\n\n#include \"json_decode.h\"\n", guard, guard);
+
+    for (int s = 0; s < struct_count; s++) {
+        const struct_spec *st = &structs[s];
+        char prefix[NAME_LEN];
+        upper(st->name, prefix);
+
+        fprintf(out, "\n");
+        for (int f = 0; f < st->field_count; f++) {
+            char field[NAME_LEN];
+            upper(st->fields[f].name, field);
+            fprintf(out, "#define %s_HAS_%s (1u << %d)\n", prefix, field, f);
+        }
+
+        fprintf(out, "\ntypedef struct {\n    uint32_t present;\n");
+        for (int f = 0; f < st->field_count; f++) {
+            const field_spec *field = &st->fields[f];
+            const char *c_type = type_table[field->type].c_type;
+            if (field->type == FIELD_STRING) {
+                fprintf(out, "    char %s[%d];\n", field->name, field->size);
+            } else if (is_array(field->type)) {
+                fprintf(out, "    %s *%s;\n    size_t %s_count;\n", c_type, field->name, field->name);
+            } else {
+                fprintf(out, "    %s %s;\n", c_type, field->name);
+            }
+        }
+        fprintf(out, "} %s;\n\n", st->name);
+
+        fprintf(out, "int decode_%s(const char *json, size_t length, %s *out);\n", st->name, st->name);
+        fprintf(out, "int decode_%s_value(json_cursor *c, %s *out);\n", st->name, st->name);
+        fprintf(out, "int decode_%s_array(const char *json, size_t length, int (*each)(const %s *value, void *user), void *user);\n",
+                st->name, st->name);
+        fprintf(out, "void free_%s(%s *value);\n", st->name, st->name);
+    }
+
+    fprintf(out, "\n#endif\n");
+}
+
+static void write_decoder(FILE *out, const struct_spec *st) {
+    char prefix[NAME_LEN];
+    upper(st->name, prefix);
+
+    fprintf(out, "\nvoid free_%s(%s *value) {\n", st->name, st->name);
+    int arrays = 0;
+    for (int f = 0; f < st->field_count; f++) {
+        const field_spec *field = &st->fields[f];
+        if (!is_array(field->type)) continue;
+        fprintf(out, "    free(value->%s);\n    value->%s = NULL;\n    value->%s_count = 0;\n", field->name, field->name,
+                field->name);
+        arrays++;
+    }
+    if (arrays == 0) fprintf(out, "    (void)value;\n");
+    fprintf(out, "}\n");
+
+    fprintf(out, "\nint decode_%s_value(json_cursor *c, %s *out) {\n", st->name, st->name);
+    fprintf(out, "    memset(out, 0, sizeof(*out));\n");
+    fprintf(out, "    if (json_begin_object(c) != 0) return -1;\n\n");
+    fprintf(out, "    for (int first = 1; ; first = 0) {\n");
+    fprintf(out, "        const char *key;\n        size_t key_length;\n");
+    fprintf(out, "        int rc = json_next_member(c, first, &key, &key_length);\n");
+    fprintf(out, "        if (rc == 0) return 0;\n        if (rc < 0) break;\n");
+    fprintf(out, "        if (json_null(c)) continue;\n\n");
+
+    for (int f = 0; f < st->field_count; f++) {
+        const field_spec *field = &st->fields[f];
+        char bit[NAME_LEN * 2];
+        upper(field->name, bit);
+        fprintf(out, "        %sif (key_length == %zu && memcmp(key, \"%s\", %zu) == 0 && !(out->present & %s_HAS_%s)) {\n",
+                f ? "} else " : "", strlen(field->key), field->key, strlen(field->key), prefix, bit);
+        if (field->type == FIELD_STRING) {
+            fprintf(out, "            rc = json_read_string(c, out->%s, sizeof(out->%s));\n", field->name, field->name);
+        } else if (is_array(field->type)) {
+            fprintf(out, "            rc = %s(c, &out->%s, &out->%s_count);\n", type_table[field->type].reader, field->name,
+                    field->name);
+        } else {
+            fprintf(out, "            rc = %s(c, &out->%s);\n", type_table[field->type].reader, field->name);
+        }
+        fprintf(out, "            out->present |= %s_HAS_%s;\n", prefix, bit);
+    }
+    fprintf(out, "        } else {\n            rc = json_skip_value(c);\n        }\n");
+    fprintf(out, "        if (rc != 0) break;\n    }\n\n");
+    fprintf(out, "    free_%s(out);\n    return -1;\n}\n", st->name);
+
+    fprintf(out, "\nint decode_%s(const char *json, size_t length, %s *out) {\n", st->name, st->name);
+    fprintf(out, "    json_cursor c;\n    json_cursor_init(&c, json, length);\n");
+    fprintf(out, "    if (decode_%s_value(&c, out) != 0) return -1;\n", st->name);
+    fprintf(out, "    if (json_end(&c) != 0) {\n        free_%s(out);\n        return -1;\n    }\n", st->name);
+    fprintf(out, "    return 0;\n}\n");
+
+    fprintf(out, "\n/* Decodes the elements of a top-level array one at a time; returns how many were decoded or -1. */\n");
+    fprintf(out, "int decode_%s_array(const char *json, size_t length, int (*each)(const %s *value, void *user), void *user) {\n",
+            st->name, st->name);
+    fprintf(out, "    json_cursor c;\n    %s value;\n    int count = 0;\n", st->name);
+    fprintf(out, "    json_cursor_init(&c, json, length);\n");
+    fprintf(out, "    if (json_begin_array(&c) != 0) return -1;\n\n");
+    fprintf(out, "    for (int first = 1; ; first = 0) {\n");
+    fprintf(out, "        int rc = json_next_element(&c, first);\n");
+    fprintf(out, "        if (rc == 0) return json_end(&c) == 0 ? count : -1;\n");
+    fprintf(out, "        if (rc < 0 || decode_%s_value(&c, &value) != 0) return -1;\n", st->name);
+    fprintf(out, "        count++;\n        rc = each(&value, user);\n        free_%s(&value);\n", st->name);
+    fprintf(out, "        if (!rc) return count;\n    }\n}\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <schema> <output stem>\n", argv[0]);
+        return 1;
+    }
+    if (parse_schema(argv[1]) != 0) return 1;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s.h", argv[2]);
+    FILE *header = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.c", argv[2]);
+    FILE *source = fopen(path, "w");
+    if (header == NULL || source == NULL) {
+        fprintf(stderr, "Cannot write %s.[ch]\n", argv[2]);
+        return 1;
+    }
+
+    const char *base = strrchr(argv[2], '/');
+    base = base ? base + 1 : argv[2];
+    write_header(header, argv[1], base);
+
+    fprintf(source, "/* Generated by gen_decoders from %s. Do not edit. */\n", argv[1]);
+    fprintf(source, "#include \"%s.h\"\n#include <stdlib.h>\n#include <string.h>\n", base);
+    for (int s = 0; s < struct_count; s++) {
+        write_decoder(source, &structs[s]);
+    }
+
+    int failed = ferror(header) || ferror(source);
+    failed |= fclose(header) != 0;
+    failed |= fclose(source) != 0;
+    return failed ? 1 : 0;
+}
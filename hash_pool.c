@@ -0,0 +1,127 @@
+#include "hash_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define DEFAULT_QUEUE_LIMIT 64
+#define MAX_THREADS 64
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MAX_THREADS];
+static int worker_count;
+static int started;
+static int stopping;
+static hash_task *head, *tail;
+static int queued;
+static int limit;
+
+static void *hash_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (head == NULL && !stopping) pthread_cond_wait(&work_ready, &pool_lock);
+        if (head == NULL) break;
+
+        hash_task *task = head;
+        head = task->next;
+        if (head == NULL) tail = NULL;
+        queued--;
+        pthread_mutex_unlock(&pool_lock);
+
+        task->run(task);
+
+        pthread_mutex_lock(&pool_lock);
+        task->done = 1;
+        pthread_cond_broadcast(&work_done);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+static int start_locked(int threads, int queue_limit) {
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 1 ? (int)(cores / 2) : 1;
+    }
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    limit = queue_limit > 0 ? queue_limit : DEFAULT_QUEUE_LIMIT;
+    stopping = 0;
+
+    for (worker_count = 0; worker_count < threads; worker_count++) {
+        if (pthread_create(&workers[worker_count], NULL, hash_worker, NULL) != 0) break;
+    }
+    if (worker_count == 0) {
+        fprintf(stderr, "Failed to start password hashing threads.\n");
+        return -1;
+    }
+    started = 1;
+    return 0;
+}
+
+int hash_pool_start(int threads, int queue_limit) {
+    pthread_mutex_lock(&pool_lock);
+    int rc = started ? 0 : start_locked(threads, queue_limit);
+    pthread_mutex_unlock(&pool_lock);
+    return rc;
+}
+
+void hash_pool_stop(void) {
+    pthread_mutex_lock(&pool_lock);
+    if (!started) {
+        pthread_mutex_unlock(&pool_lock);
+        return;
+    }
+    stopping = 1;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    /* queued tasks still run before the workers exit */
+    for (int i = 0; i < worker_count; i++) pthread_join(workers[i], NULL);
+
+    pthread_mutex_lock(&pool_lock);
+    started = 0;
+    worker_count = 0;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+int hash_pool_submit(hash_task *task) {
+    pthread_mutex_lock(&pool_lock);
+    if (!started) {
+        const char *threads = getenv("STOCKSIM_HASH_THREADS");
+        const char *queue = getenv("STOCKSIM_HASH_QUEUE");
+        if (start_locked(threads ? atoi(threads) : 0, queue ? atoi(queue) : 0) != 0) {
+            pthread_mutex_unlock(&pool_lock);
+            return -1;
+        }
+    }
+    if (queued >= limit || stopping) {
+        task->done = 1;     /* nothing to wait for */
+        pthread_mutex_unlock(&pool_lock);
+        return HASH_POOL_BUSY;
+    }
+
+    task->done = 0;
+    task->next = NULL;
+    if (tail != NULL) tail->next = task;
+    else head = task;
+    tail = task;
+    queued++;
+    pthread_cond_signal(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+    return 0;
+}
+
+void hash_pool_wait(hash_task *task) {
+    pthread_mutex_lock(&pool_lock);
+    while (!task->done) pthread_cond_wait(&work_done, &pool_lock);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+int hash_pool_run(hash_task *task) {
+    int rc = hash_pool_submit(task);
+    if (rc == 0) hash_pool_wait(task);
+    return rc;
+}
@@ -0,0 +1,29 @@
+#ifndef HASH_POOL_H
+#define HASH_POOL_H
+
+/*
+ * A small fixed set of threads for password hashing. The queue in front of
+ * them is bounded: when it is full, hash_pool_submit() refuses the task
+ * instead of letting a login burst pile up work, and the caller reports
+ * "busy". Everything else keeps the remaining cores.
+ */
+typedef struct hash_task {
+    void (*run)(struct hash_task *task);
+    int done;
+    struct hash_task *next;
+} hash_task;
+
+#define HASH_POOL_BUSY -2
+
+/* Starts threads workers (<= 0: half the cores, at least one) with room for queue_limit waiting tasks.
+ * Called implicitly with STOCKSIM_HASH_THREADS / STOCKSIM_HASH_QUEUE on first use. */
+int hash_pool_start(int threads, int queue_limit);
+void hash_pool_stop(void);
+
+/* 0 when queued, HASH_POOL_BUSY when the queue is full. */
+int hash_pool_submit(hash_task *task);
+void hash_pool_wait(hash_task *task);
+/* Submit and wait. */
+int hash_pool_run(hash_task *task);
+
+#endif
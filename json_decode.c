@@ -0,0 +1,338 @@
+#include "json_decode.h"
+#include "cJSON.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SKIP_DEPTH 256
+
+void json_cursor_init(json_cursor *c, const char *json, size_t length) {
+    c->p = json;
+    c->end = json + length;
+}
+
+static void skip_whitespace(json_cursor *c) {
+    while (c->p < c->end && (unsigned char)*c->p <= ' ') c->p++;
+}
+
+static int expect(json_cursor *c, char ch) {
+    skip_whitespace(c);
+    if (c->p >= c->end || *c->p != ch) return -1;
+    c->p++;
+    return 0;
+}
+
+int json_begin_object(json_cursor *c) {
+    return expect(c, '{');
+}
+
+int json_begin_array(json_cursor *c) {
+    return expect(c, '[');
+}
+
+/* Advances past the closing quote of a string whose opening quote was consumed. */
+static int skip_string_body(json_cursor *c) {
+    while (c->p < c->end) {
+        char ch = *c->p++;
+        if (ch == '"') return 0;
+        if (ch == '\\') {
+            if (c->p >= c->end) return -1;
+            c->p++;
+        }
+    }
+    return -1;
+}
+
+int json_next_member(json_cursor *c, int first, const char **key, size_t *key_length) {
+    skip_whitespace(c);
+    if (c->p >= c->end) return -1;
+    if (*c->p == '}') {
+        c->p++;
+        return 0;
+    }
+    if (!first && expect(c, ',') != 0) return -1;
+    if (expect(c, '"') != 0) return -1;
+
+    *key = c->p;
+    if (skip_string_body(c) != 0) return -1;
+    *key_length = (size_t)(c->p - 1 - *key);
+    return expect(c, ':') == 0 ? 1 : -1;
+}
+
+int json_next_element(json_cursor *c, int first) {
+    skip_whitespace(c);
+    if (c->p >= c->end) return -1;
+    if (*c->p == ']') {
+        c->p++;
+        return 0;
+    }
+    if (!first && expect(c, ',') != 0) return -1;
+    return 1;
+}
+
+static int literal(json_cursor *c, const char *word, size_t length) {
+    if ((size_t)(c->end - c->p) < length || memcmp(c->p, word, length) != 0) return 0;
+    c->p += length;
+    return 1;
+}
+
+int json_null(json_cursor *c) {
+    skip_whitespace(c);
+    return literal(c, "null", 4);
+}
+
+int json_end(json_cursor *c) {
+    skip_whitespace(c);
+    return c->p == c->end ? 0 : -1;
+}
+
+/* The text of a number token, left for the caller to convert. */
+static int number_token(json_cursor *c, const char **start, size_t *length) {
+    skip_whitespace(c);
+    *start = c->p;
+    while (c->p < c->end && ((*c->p >= '0' && *c->p <= '9') || *c->p == '-' || *c->p == '+' || *c->p == '.' ||
+                             *c->p == 'e' || *c->p == 'E')) {
+        c->p++;
+    }
+    *length = (size_t)(c->p - *start);
+    return *length > 0 ? 0 : -1;
+}
+
+static int skip_value_at(json_cursor *c, int depth) {
+    if (depth > MAX_SKIP_DEPTH) return -1;
+    skip_whitespace(c);
+    if (c->p >= c->end) return -1;
+
+    switch (*c->p) {
+        case '"':
+            c->p++;
+            return skip_string_body(c);
+        case '{': {
+            const char *key;
+            size_t key_length;
+            c->p++;
+            for (int first = 1; ; first = 0) {
+                int rc = json_next_member(c, first, &key, &key_length);
+                if (rc <= 0) return rc;
+                if (skip_value_at(c, depth + 1) != 0) return -1;
+            }
+        }
+        case '[':
+            c->p++;
+            for (int first = 1; ; first = 0) {
+                int rc = json_next_element(c, first);
+                if (rc <= 0) return rc;
+                if (skip_value_at(c, depth + 1) != 0) return -1;
+            }
+        case 't':
+            return literal(c, "true", 4) ? 0 : -1;
+        case 'f':
+            return literal(c, "false", 5) ? 0 : -1;
+        case 'n':
+            return literal(c, "null", 4) ? 0 : -1;
+        default: {
+            double ignored;
+            return json_read_double(c, &ignored);
+        }
+    }
+}
+
+int json_skip_value(json_cursor *c) {
+    return skip_value_at(c, 0);
+}
+
+int json_read_double(json_cursor *c, double *value) {
+    cJSON_Slice slice = { cJSON_Number, NULL, 0 };
+    if (number_token(c, &slice.start, &slice.length) != 0) return -1;
+    return cJSON_SliceToNumber(&slice, value) ? 0 : -1;
+}
+
+/* Plain integers are read exactly; anything with a fraction or exponent is truncated like a cast. */
+int json_read_int64(json_cursor *c, int64_t *value) {
+    const char *start;
+    size_t length;
+    if (number_token(c, &start, &length) != 0) return -1;
+
+    size_t i = (start[0] == '-') ? 1 : 0;
+    if (length > i && length - i <= 18) {
+        int64_t n = 0;
+        for (; i < length && start[i] >= '0' && start[i] <= '9'; i++) n = n * 10 + (start[i] - '0');
+        if (i == length) {
+            *value = start[0] == '-' ? -n : n;
+            return 0;
+        }
+    }
+
+    cJSON_Slice slice = { cJSON_Number, start, length };
+    double number;
+    if (!cJSON_SliceToNumber(&slice, &number)) return -1;
+    *value = (int64_t)number;
+    return 0;
+}
+
+/* Prices go straight from decimal text to micro-dollars, without a double in between. */
+int json_read_money(json_cursor *c, money_t *value) {
+    const char *start;
+    size_t length;
+    if (number_token(c, &start, &length) != 0) return -1;
+    return money_parse(start, length, value);
+}
+
+static int hex4(const char *p, unsigned *value) {
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char ch = p[i];
+        *value <<= 4;
+        if (ch >= '0' && ch <= '9') *value |= (unsigned)(ch - '0');
+        else if (ch >= 'a' && ch <= 'f') *value |= (unsigned)(ch - 'a' + 10);
+        else if (ch >= 'A' && ch <= 'F') *value |= (unsigned)(ch - 'A' + 10);
+        else return -1;
+    }
+    return 0;
+}
+
+static size_t encode_utf8(unsigned code, char *out) {
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char)(0xE0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+/* Decodes one escape sequence after the backslash into out; returns the byte count or 0 if invalid. */
+static size_t decode_escape(json_cursor *c, char *out) {
+    if (c->p >= c->end) return 0;
+    char ch = *c->p++;
+    switch (ch) {
+        case '"': case '\\': case '/':
+            out[0] = ch;
+            return 1;
+        case 'b': out[0] = '\b'; return 1;
+        case 'f': out[0] = '\f'; return 1;
+        case 'n': out[0] = '\n'; return 1;
+        case 'r': out[0] = '\r'; return 1;
+        case 't': out[0] = '\t'; return 1;
+        case 'u': {
+            unsigned code, low;
+            if (c->end - c->p < 4 || hex4(c->p, &code) != 0) return 0;
+            c->p += 4;
+            if (code >= 0xDC00 && code <= 0xDFFF) return 0;
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                if (c->end - c->p < 6 || c->p[0] != '\\' || c->p[1] != 'u' || hex4(c->p + 2, &low) != 0 ||
+                    low < 0xDC00 || low > 0xDFFF) {
+                    return 0;
+                }
+                c->p += 6;
+                code = 0x10000 + (((code & 0x3FF) << 10) | (low & 0x3FF));
+            }
+            return encode_utf8(code, out);
+        }
+        default:
+            return 0;
+    }
+}
+
+int json_read_string(json_cursor *c, char *buffer, size_t size) {
+    if (size == 0 || expect(c, '"') != 0) return -1;
+
+    size_t length = 0;
+    int full = 0;
+    while (c->p < c->end) {
+        char ch = *c->p++;
+        char bytes[4];
+        size_t count = 1;
+        if (ch == '"') {
+            buffer[length] = '\0';
+            return 0;
+        }
+        if (ch == '\\') {
+            count = decode_escape(c, bytes);
+            if (count == 0) return -1;
+        } else if (!full && (unsigned char)ch >= 0xC0) {
+            /* copy a whole multi-byte character or none of it */
+            count = (unsigned char)ch >= 0xF0 ? 4 : ((unsigned char)ch >= 0xE0 ? 3 : 2);
+            if ((size_t)(c->end - c->p) < count - 1) count = (size_t)(c->end - c->p) + 1;
+            bytes[0] = ch;
+            memcpy(bytes + 1, c->p, count - 1);
+            c->p += count - 1;
+        } else {
+            bytes[0] = ch;
+        }
+        if (full || length + count >= size) {
+            full = 1;
+            continue;
+        }
+        memcpy(buffer + length, bytes, count);
+        length += count;
+    }
+    return -1;
+}
+
+typedef int (*element_reader)(json_cursor *c, void *value);
+
+static int read_double_element(json_cursor *c, void *value) {
+    return json_read_double(c, value);
+}
+
+static int read_int64_element(json_cursor *c, void *value) {
+    return json_read_int64(c, value);
+}
+
+static int read_money_element(json_cursor *c, void *value) {
+    return json_read_money(c, value);
+}
+
+static int read_array(json_cursor *c, element_reader read, size_t element_size, void **items, size_t *count) {
+    *items = NULL;
+    *count = 0;
+    if (json_null(c)) return 0;
+    if (json_begin_array(c) != 0) return -1;
+
+    char *out = NULL;
+    size_t n = 0, capacity = 0;
+    for (int first = 1; ; first = 0) {
+        int rc = json_next_element(c, first);
+        if (rc == 0) break;
+        if (rc > 0 && n == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            char *grown = realloc(out, capacity * element_size);
+            if (grown == NULL) rc = -1;
+            else out = grown;
+        }
+        if (rc < 0 || read(c, out + n * element_size) != 0) {
+            free(out);
+            return -1;
+        }
+        n++;
+    }
+
+    *items = out;
+    *count = n;
+    return 0;
+}
+
+int json_read_double_array(json_cursor *c, double **items, size_t *count) {
+    return read_array(c, read_double_element, sizeof(double), (void **)items, count);
+}
+
+int json_read_int64_array(json_cursor *c, int64_t **items, size_t *count) {
+    return read_array(c, read_int64_element, sizeof(int64_t), (void **)items, count);
+}
+
+int json_read_money_array(json_cursor *c, money_t **items, size_t *count) {
+    return read_array(c, read_money_element, sizeof(money_t), (void **)items, count);
+}
@@ -0,0 +1,44 @@
+#ifndef JSON_DECODE_H
+#define JSON_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "money.h"
+
+/*
+ * Pull reader over JSON text for the generated decoders (see gen_decoders.c).
+ * Values are read straight into caller-owned fields; anything not read is
+ * skipped in place, so decoding allocates only for number arrays.
+ */
+typedef struct {
+    const char *p;
+    const char *end;
+} json_cursor;
+
+void json_cursor_init(json_cursor *c, const char *json, size_t length);
+
+/* 1 when the next value is an object member (cursor on its value), 0 at the end
+ * of the object, -1 on malformed input. first is 1 for the call after json_begin_object. */
+int json_begin_object(json_cursor *c);
+int json_next_member(json_cursor *c, int first, const char **key, size_t *key_length);
+int json_begin_array(json_cursor *c);
+int json_next_element(json_cursor *c, int first);
+
+/* Consumes a null and returns 1, or returns 0 if the next value is not null. */
+int json_null(json_cursor *c);
+int json_skip_value(json_cursor *c);
+/* 0 if only whitespace is left. */
+int json_end(json_cursor *c);
+
+int json_read_double(json_cursor *c, double *value);
+int json_read_int64(json_cursor *c, int64_t *value);
+int json_read_money(json_cursor *c, money_t *value);
+/* Decodes escapes; longer strings are cut at a UTF-8 character boundary to fit size. */
+int json_read_string(json_cursor *c, char *buffer, size_t size);
+
+/* Arrays of numbers; *items is malloc'd (NULL when empty) and owned by the caller. */
+int json_read_double_array(json_cursor *c, double **items, size_t *count);
+int json_read_int64_array(json_cursor *c, int64_t **items, size_t *count);
+int json_read_money_array(json_cursor *c, money_t **items, size_t *count);
+
+#endif
@@ -0,0 +1,183 @@
+#include "latency.h"
+#include <stdatomic.h>
+#include <time.h>
+
+#define SUB_BUCKET_BITS 5
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define MAX_BITS 40             /* values are clamped below 2^40 ns, about 18 minutes */
+#define BUCKETS ((MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+typedef struct {
+    _Atomic uint64_t counts[BUCKETS];
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+} histogram;
+
+static histogram histograms[LATENCY_METRICS];
+
+static const char *metric_names[LATENCY_METRICS] = {
+    [LAT_FETCH_PRICE] = "api.fetch_stock_price",
+    [LAT_FETCH_QUOTE] = "api.fetch_stock_quote",
+    [LAT_FETCH_CANDLES] = "api.fetch_stock_candles",
+    [LAT_FETCH_DETAILS] = "api.fetch_stock_details",
+    [LAT_HTTP] = "api.http_request",
+    [LAT_JSON_PARSE] = "api.json_parse",
+    [LAT_DB_OPEN] = "db.open",
+    [LAT_DB_BUY] = "db.buy_stocks",
+    [LAT_DB_SELL] = "db.sell_stocks",
+    [LAT_DB_PORTFOLIO] = "db.view_portfolio",
+    [LAT_DB_RISK] = "db.view_portfolio_risk",
+    [LAT_DB_TRANSACTIONS] = "db.view_transactions",
+    [LAT_DB_LEADERBOARD] = "db.view_leaderboard",
+    [LAT_DB_PROFILE] = "db.view_user_details",
+    [LAT_DB_WATCHLIST_EDIT] = "db.change_watchlist",
+    [LAT_DB_WATCHLIST] = "db.view_watchlist",
+    [LAT_AUTH_SIGNUP] = "auth.signup",
+    [LAT_AUTH_LOGIN] = "auth.login",
+    [LAT_AUTH_PBKDF2] = "auth.pbkdf2",
+    [LAT_BUY_OPEN] = "buy.open",
+    [LAT_BUY_READ] = "buy.read",
+    [LAT_BUY_WRITE] = "buy.write",
+    [LAT_BUY_COMMIT] = "buy.commit",
+    [LAT_SELL_OPEN] = "sell.open",
+    [LAT_SELL_READ] = "sell.read",
+    [LAT_SELL_WRITE] = "sell.write",
+    [LAT_SELL_COMMIT] = "sell.commit",
+};
+
+uint64_t latency_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Exact below 2 * SUB_BUCKETS, then SUB_BUCKETS buckets per power of two. */
+static int bucket_index(uint64_t value) {
+    if (value >= (1ULL << MAX_BITS)) value = (1ULL << MAX_BITS) - 1;
+    if (value < 2 * SUB_BUCKETS) return (int)value;
+    int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKETS + (int)(value >> shift);
+}
+
+static void bucket_range(int index, uint64_t *low, uint64_t *high) {
+    if (index < 2 * SUB_BUCKETS) {
+        *low = *high = (uint64_t)index;
+        return;
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = (uint64_t)(index - shift * SUB_BUCKETS);
+    *low = sub << shift;
+    *high = ((sub + 1) << shift) - 1;
+}
+
+void latency_record_value(latency_metric metric, uint64_t value) {
+    histogram *h = &histograms[metric];
+    atomic_fetch_add_explicit(&h->counts[bucket_index(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (value > max && !atomic_compare_exchange_weak_explicit(&h->max, &max, value, memory_order_relaxed,
+                                                                  memory_order_relaxed)) {}
+}
+
+uint64_t latency_record(latency_metric metric, uint64_t start) {
+    uint64_t now = latency_now();
+    latency_record_value(metric, now > start ? now - start : 0);
+    return now;
+}
+
+/* A copy of one histogram; recording carries on while it is taken, so it is only nearly consistent. */
+typedef struct {
+    uint64_t counts[BUCKETS];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t max;
+} snapshot;
+
+static void take_snapshot(latency_metric metric, snapshot *s) {
+    histogram *h = &histograms[metric];
+    s->total = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        s->counts[i] = atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        s->total += s->counts[i];
+    }
+    s->sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    s->max = atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+/* The highest value in the bucket holding the p-th fraction of samples, as milliseconds. */
+static double percentile_ms(const snapshot *s, double p) {
+    uint64_t rank = (uint64_t)(p * (double)s->total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += s->counts[i];
+        if (seen >= rank) {
+            uint64_t low, high;
+            bucket_range(i, &low, &high);
+            return (double)(high < s->max ? high : s->max) / 1e6;
+        }
+    }
+    return (double)s->max / 1e6;
+}
+
+static const struct {
+    const char *title;
+    latency_metric total;
+    latency_metric first;
+    latency_metric last;
+} trades[] = {
+    { "buy_stocks phases", LAT_DB_BUY, LAT_BUY_OPEN, LAT_BUY_COMMIT },
+    { "sell_stocks phases", LAT_DB_SELL, LAT_SELL_OPEN, LAT_SELL_COMMIT },
+};
+
+void latency_report(FILE *out) {
+    snapshot s;
+    fprintf(out, "%-26s %9s %10s %10s %10s %10s %10s %10s\n", "metric", "count", "mean ms", "p50 ms", "p90 ms",
+            "p99 ms", "p99.9 ms", "max ms");
+    int shown = 0;
+    for (int m = 0; m < LAT_BUY_OPEN; m++) {
+        take_snapshot(m, &s);
+        if (s.total == 0) continue;
+        fprintf(out, "%-26s %9llu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", metric_names[m],
+                (unsigned long long)s.total, (double)s.sum / (double)s.total / 1e6, percentile_ms(&s, 0.50),
+                percentile_ms(&s, 0.90), percentile_ms(&s, 0.99), percentile_ms(&s, 0.999), (double)s.max / 1e6);
+        shown++;
+    }
+    if (shown == 0) fprintf(out, "(nothing recorded yet)\n");
+
+    /* A rejected trade returns early, so later phases can have smaller counts. */
+    for (size_t t = 0; t < sizeof(trades) / sizeof(trades[0]); t++) {
+        take_snapshot(trades[t].total, &s);
+        if (s.total == 0) continue;
+        double trade_sum = (double)s.sum;
+        fprintf(out, "\n%-26s %9s %10s %10s %10s %10s\n", trades[t].title, "count", "mean ms", "p50 ms", "p99 ms",
+                "share");
+        for (latency_metric m = trades[t].first; m <= trades[t].last; m++) {
+            take_snapshot(m, &s);
+            fprintf(out, "%-26s %9llu %10.3f %10.3f %10.3f %9.1f%%\n", metric_names[m], (unsigned long long)s.total,
+                    s.total ? (double)s.sum / (double)s.total / 1e6 : 0.0, s.total ? percentile_ms(&s, 0.50) : 0.0,
+                    s.total ? percentile_ms(&s, 0.99) : 0.0, 100.0 * (double)s.sum / trade_sum);
+        }
+    }
+}
+
+int latency_dump(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return -1;
+    }
+    fprintf(file, "metric,low_ns,high_ns,count\n");
+    for (int m = 0; m < LATENCY_METRICS; m++) {
+        histogram *h = &histograms[m];
+        for (int i = 0; i < BUCKETS; i++) {
+            uint64_t count = atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+            if (count == 0) continue;
+            uint64_t low, high;
+            bucket_range(i, &low, &high);
+            fprintf(file, "%s,%llu,%llu,%llu\n", metric_names[m], (unsigned long long)low, (unsigned long long)high,
+                    (unsigned long long)count);
+        }
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
@@ -0,0 +1,58 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Latency histograms for the slow paths: quote fetches, JSON parsing, every
+ * database.c operation, auth, and the phases of a trade. Buckets are
+ * log-linear as in HdrHistogram (32 per power of two, so a value lands in a
+ * bucket within about 3% of it) and counts are relaxed atomics, so recording
+ * costs two clock reads and a few uncontended increments and is always on.
+ */
+typedef enum {
+    LAT_FETCH_PRICE,
+    LAT_FETCH_QUOTE,
+    LAT_FETCH_CANDLES,
+    LAT_FETCH_DETAILS,
+    LAT_HTTP,
+    LAT_JSON_PARSE,
+    LAT_DB_OPEN,
+    LAT_DB_BUY,
+    LAT_DB_SELL,
+    LAT_DB_PORTFOLIO,
+    LAT_DB_RISK,
+    LAT_DB_TRANSACTIONS,
+    LAT_DB_LEADERBOARD,
+    LAT_DB_PROFILE,
+    LAT_DB_WATCHLIST_EDIT,
+    LAT_DB_WATCHLIST,
+    LAT_AUTH_SIGNUP,
+    LAT_AUTH_LOGIN,
+    LAT_AUTH_PBKDF2,
+    /* phases of buy_stocks()/sell_stocks(), in order */
+    LAT_BUY_OPEN,
+    LAT_BUY_READ,
+    LAT_BUY_WRITE,
+    LAT_BUY_COMMIT,
+    LAT_SELL_OPEN,
+    LAT_SELL_READ,
+    LAT_SELL_WRITE,
+    LAT_SELL_COMMIT,
+    LATENCY_METRICS
+} latency_metric;
+
+/* Monotonic nanoseconds. */
+uint64_t latency_now(void);
+/* Records the time since start and returns the current time, so phases can be chained. */
+uint64_t latency_record(latency_metric metric, uint64_t start);
+/* Records a duration measured some other way, e.g. summed over several pieces. */
+void latency_record_value(latency_metric metric, uint64_t nanoseconds);
+
+/* Count, mean, percentiles and max per metric, then each trade phase's share of the trade. */
+void latency_report(FILE *out);
+/* Every non-empty bucket as "metric,low_ns,high_ns,count" CSV rows. */
+int latency_dump(const char *path);
+
+#endif
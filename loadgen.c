@@ -0,0 +1,295 @@
+// loadgen.c
+#include "database.h"
+#include "auth.h"
+#include "api.h"
+#include "latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/*
+ * Simulated traders against the real auth.c/database.c functions, in one
+ * process, with the local quote stand-in. Each user is a thread that picks
+ * operations by weight from the mix, sleeps an exponentially distributed
+ * think time between them, and records the latency of each one.
+ */
+#define SETUP_CASH MONEY_DOLLARS(1000000000)     /* so buys never run dry */
+
+typedef enum { OP_BUY, OP_SELL, OP_PORTFOLIO, OP_TRANSACTIONS, OP_LEADERBOARD, OP_PRICE, OP_LOGIN, OP_COUNT } op_kind;
+
+static const char *op_names[OP_COUNT] = { "buy", "sell", "portfolio", "transactions", "leaderboard", "price", "login" };
+
+typedef struct {
+    double *ms;
+    size_t count;
+    size_t capacity;
+    size_t errors;
+} op_samples;
+
+typedef struct {
+    int user_id;
+    uint64_t rng;
+    op_samples ops[OP_COUNT];
+} trader;
+
+static int mix[OP_COUNT] = { 40, 30, 15, 5, 5, 5, 0 };
+static int mix_total;
+static int symbol_count = 20;
+static double think_ms;
+static uint64_t deadline;        /* latency_now() at which traders stop */
+
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in (0, 1]. */
+static double next_unit(uint64_t *state) {
+    return ((next_random(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static void record(op_samples *samples, double ms, int ok) {
+    if (samples->count == samples->capacity) {
+        size_t capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        double *grown = realloc(samples->ms, capacity * sizeof(double));
+        if (grown == NULL) return;
+        samples->ms = grown;
+        samples->capacity = capacity;
+    }
+    samples->ms[samples->count++] = ms;
+    if (!ok) samples->errors++;
+}
+
+static int run_op(trader *t, op_kind op) {
+    char symbol[16];
+    snprintf(symbol, sizeof(symbol), "LG%d", (int)(next_random(&t->rng) % (uint64_t)symbol_count));
+    money_t price;
+
+    switch (op) {
+        case OP_BUY:
+            if (fetch_stock_price(symbol, &price) != 0) return -1;
+            return buy_stocks(t->user_id, symbol, 1 + (int)(next_random(&t->rng) % 10), price);
+        case OP_SELL:
+            if (fetch_stock_price(symbol, &price) != 0) return -1;
+            return sell_stocks(t->user_id, symbol, 1 + (int)(next_random(&t->rng) % 5), price);
+        case OP_PORTFOLIO:
+            return view_portfolio(t->user_id);
+        case OP_TRANSACTIONS:
+            return view_transactions(t->user_id);
+        case OP_LEADERBOARD:
+            return view_leaderboard();
+        case OP_PRICE:
+            return fetch_stock_price(symbol, &price);
+        default:
+            return -1;
+    }
+}
+
+static void *trader_main(void *arg) {
+    trader *t = arg;
+    while (latency_now() < deadline) {
+        int pick = (int)(next_random(&t->rng) % (uint64_t)mix_total);
+        op_kind op = OP_BUY;
+        while (pick >= mix[op]) pick -= mix[op++];
+
+        uint64_t start = latency_now();
+        int rc = run_op(t, op);
+        record(&t->ops[op], (double)(latency_now() - start) / 1e6, rc == 0);
+
+        if (think_ms > 0.0) {
+            double pause = -think_ms * log(next_unit(&t->rng));
+            struct timespec ts = { (time_t)(pause / 1e3), (long)(fmod(pause, 1e3) * 1e6) };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* "buy=40,sell=30,portfolio=20"; operations left out get weight 0. */
+static int parse_mix(const char *text) {
+    int weights[OP_COUNT] = { 0 };
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", text);
+
+    char *save;
+    for (char *item = strtok_r(copy, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+        char *equals = strchr(item, '=');
+        if (equals == NULL) return -1;
+        *equals = '\0';
+        int op = 0;
+        while (op < OP_COUNT && strcmp(op_names[op], item) != 0) op++;
+        if (op == OP_COUNT || op == OP_LOGIN || atoi(equals + 1) < 0) return -1;
+        weights[op] = atoi(equals + 1);
+    }
+    memcpy(mix, weights, sizeof(mix));
+    return 0;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double p) {
+    if (count == 0) return 0.0;
+    size_t rank = (size_t)ceil(p * (double)count);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void report_op(FILE *out, const char *name, op_samples *s, double seconds) {
+    double sum = 0.0;
+    for (size_t i = 0; i < s->count; i++) sum += s->ms[i];
+    qsort(s->ms, s->count, sizeof(double), compare_doubles);
+    fprintf(out, "%-13s %8zu %7zu %9.1f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, s->count, s->errors,
+            seconds > 0 ? s->count / seconds : 0.0, s->count ? sum / s->count : 0.0, percentile(s->ms, s->count, 0.50),
+            percentile(s->ms, s->count, 0.99), percentile(s->ms, s->count, 0.999), s->count ? s->ms[s->count - 1] : 0.0);
+}
+
+static void merge(op_samples *into, const op_samples *from) {
+    for (size_t i = 0; i < from->count; i++) record(into, from->ms[i], 1);
+    into->errors += from->errors;
+}
+
+/* Signs up (if needed) and logs in loadgen user i, with cash to spare. */
+static int setup_trader(trader *t, int i, op_samples *login_samples) {
+    char username[32], password[32];
+    snprintf(username, sizeof(username), "loadgen%d", i);
+    snprintf(password, sizeof(password), "loadgen%d-pw", i);
+    int rc = signup(username, password);
+    if (rc != 0 && rc != AUTH_TAKEN) return -1;
+
+    uint64_t start = latency_now();
+    rc = login(username, password, &t->user_id);
+    record(login_samples, (double)(latency_now() - start) / 1e6, rc == 0);
+    if (rc != 0) return -1;
+
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "UPDATE users SET cash_balance = ? WHERE id = ?;", -1, &stmt, 0) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, SETUP_CASH);
+        sqlite3_bind_int(stmt, 2, t->user_id);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    close_database(db);
+    return 0;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-u users] [-d seconds] [-t think ms] [-m buy=40,sell=30,...] [-s symbols] [-c iterations] [-o stats.csv]\n"
+                    "Operations: buy, sell, portfolio, transactions, leaderboard, price.\n", program);
+}
+
+int main(int argc, char **argv) {
+    int users = 8;
+    double seconds = 10.0;
+    int iterations = 1000;
+    const char *stats_file = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "u:d:t:m:s:c:o:")) != -1) {
+        switch (opt) {
+            case 'u': users = atoi(optarg); break;
+            case 'd': seconds = atof(optarg); break;
+            case 't': think_ms = atof(optarg); break;
+            case 'm':
+                if (parse_mix(optarg) != 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 's': symbol_count = atoi(optarg); break;
+            case 'c': iterations = atoi(optarg); break;
+            case 'o': stats_file = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    mix_total = 0;
+    for (int op = 0; op < OP_COUNT; op++) mix_total += mix[op];
+    if (optind != argc || users <= 0 || seconds <= 0 || think_ms < 0 || symbol_count <= 0 || mix_total <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* a scratch database and offline quotes unless told otherwise */
+    setenv("STOCKSIM_DB", "loadgen.db", 0);
+    api_set_local_mode(1);
+    set_password_cost(iterations);
+
+    /* the trading functions print for people; keep stdout for the report */
+    fflush(stdout);
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (out == NULL || null_fd < 0 || dup2(null_fd, STDOUT_FILENO) < 0) {
+        fprintf(stderr, "Cannot redirect output.\n");
+        return 1;
+    }
+    close(null_fd);
+
+    if (initialize_database() != SQLITE_OK) return 1;
+
+    trader *traders = calloc((size_t)users, sizeof(trader));
+    pthread_t *threads = calloc((size_t)users, sizeof(pthread_t));
+    op_samples login_samples = { 0 };
+    if (traders == NULL || threads == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    for (int i = 0; i < users; i++) {
+        traders[i].rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        if (setup_trader(&traders[i], i, &login_samples) != 0) {
+            fprintf(stderr, "Failed to set up user loadgen%d.\n", i);
+            return 1;
+        }
+    }
+
+    uint64_t start = latency_now();
+    deadline = start + (uint64_t)(seconds * 1e9);
+    int started = 0;
+    for (; started < users; started++) {
+        if (pthread_create(&threads[started], NULL, trader_main, &traders[started]) != 0) break;
+    }
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    double elapsed = (double)(latency_now() - start) / 1e9;
+
+    fprintf(out, "%d users (%d running), %.1f s, think %.1f ms, %d symbols, database %s\n", users, started, elapsed,
+            think_ms, symbol_count, getenv("STOCKSIM_DB"));
+    fprintf(out, "%-13s %8s %7s %9s %9s %9s %9s %9s %9s\n", "op", "count", "errors", "ops/s", "mean ms", "p50 ms",
+            "p99 ms", "p999 ms", "max ms");
+
+    op_samples all = { 0 };
+    for (int op = 0; op < OP_LOGIN; op++) {
+        op_samples merged = { 0 };
+        for (int i = 0; i < started; i++) merge(&merged, &traders[i].ops[op]);
+        if (merged.count > 0) report_op(out, op_names[op], &merged, elapsed);
+        merge(&all, &merged);
+        free(merged.ms);
+    }
+    report_op(out, "all", &all, elapsed);
+    report_op(out, "login (setup)", &login_samples, 0.0);
+    fprintf(out, "\n");
+    latency_report(out);
+    fclose(out);
+    if (stats_file != NULL && latency_dump(stats_file) != 0) return 1;
+
+    free(all.ms);
+    free(login_samples.ms);
+    for (int i = 0; i < users; i++) {
+        for (int op = 0; op < OP_COUNT; op++) free(traders[i].ops[op].ms);
+    }
+    free(traders);
+    free(threads);
+    return 0;
+}
@@ -2,9 +2,16 @@
 #include "database.h"
 #include "auth.h"
 #include "api.h"
+#include "username_index.h"
+#include "script.h"
+#include "quote_cache.h"
+#include "dashboard.h"
+#include "latency.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <termios.h>
+#include <unistd.h>
 #define RESET_COLOR "\033[0m"
 #define BOLD "\033[1m"
 #define UNDERLINE "\033[4m"
@@ -56,18 +63,98 @@ void show_user_menu(int user_id) {
     printf("%s6. Fetch Stock Price%s\n", GREEN, RESET_COLOR);
     printf("%s7. View Leaderboard%s\n", GREEN, RESET_COLOR);
     printf("%s8. View Profile%s\n", GREEN, RESET_COLOR);
-    printf("%s9. Logout%s\n", RED, RESET_COLOR);
+    printf("%s9. Portfolio Risk%s\n", GREEN, RESET_COLOR);
+    printf("%s10. Watchlist%s\n", GREEN, RESET_COLOR);
+    printf("%s11. Live Dashboard%s\n", GREEN, RESET_COLOR);
+    printf("%s12. Latency Stats%s\n", GREEN, RESET_COLOR);
+    printf("%s13. Logout%s\n", RED, RESET_COLOR);
     printf("%sChoose an option: %s", YELLOW, RESET_COLOR);
 }
 
-int main() {
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-b users.csv [-c iterations]] [-s script|-] [-S stats.csv]\n", program);
+}
+
+static const char *stats_file;
+
+/* -S: the latency histograms go to a file when the program exits, however it exits. */
+static void dump_stats(void) {
+    if (latency_dump(stats_file) == 0) fprintf(stderr, "Latency histograms written to %s\n", stats_file);
+}
+
+/* -b: create every "username,password" account in the file and exit. */
+static int run_bulk_signup(const char *path, int iterations) {
+    int skipped = 0;
+    uint64_t start = latency_now();
+    int created = bulk_signup(path, iterations, &skipped);
+    double elapsed = (double)(latency_now() - start) / 1e9;
+    if (created < 0) {
+        fprintf(stderr, "Bulk signup from %s failed.\n", path);
+        return 1;
+    }
+    printf("%sCreated %d users in %.2f s (%.0f users/s), %d lines skipped.%s\n", GREEN, created, elapsed,
+           elapsed > 0 ? created / elapsed : 0.0, skipped, RESET_COLOR);
+    return 0;
+}
+
+static FILE *records_out;
+
+/* -s: run a command script; records go to the real stdout, everything printed for humans to stderr. */
+static int run_script_file(const char *path) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (in == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+    int failed = run_script(in, records_out);
+    if (in != stdin) fclose(in);
+    fclose(records_out);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *bulk_file = NULL;
+    const char *script_file = NULL;
+    int iterations = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:c:s:S:")) != -1) {
+        switch (opt) {
+            case 'b': bulk_file = optarg; break;
+            case 'c': iterations = atoi(optarg); break;
+            case 's': script_file = optarg; break;
+            case 'S': stats_file = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc || (iterations != 0 && bulk_file == NULL) || iterations < 0 || (bulk_file && script_file)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (stats_file != NULL) atexit(dump_stats);
+
+    if (script_file != NULL) {
+        records_out = fdopen(dup(STDOUT_FILENO), "w");
+        if (records_out == NULL || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            fprintf(stderr, "Cannot redirect output.\n");
+            return 1;
+        }
+    }
+
     initialize_database();
+    init_username_index();
+    if (bulk_file != NULL) return run_bulk_signup(bulk_file, iterations);
+    init_sessions();
+    if (script_file != NULL) return run_script_file(script_file);
 
     int choice;
     char username[50];
     char password[50];
     char confirm_password[50];
     int user_id;
+    char session_token[SESSION_TOKEN_LEN + 1];
 
     while (1) {
         show_main_menu();
@@ -92,8 +179,15 @@ int main() {
                     break;
                 }
 
-                if (signup(username, password) != 0) {
+                int signup_rc = signup(username, password);
+                if (signup_rc == AUTH_BUSY) {
+                    printf("%sServer busy, please try again.%s\n", RED, RESET_COLOR);
+                }
+                else if (signup_rc == AUTH_TAKEN) {
                     printf("%sSignup failed: Username '%s' is already taken. Please choose a different username.%s\n", RED, username, RESET_COLOR);
+                }
+                else if (signup_rc != 0) {
+                    printf("%sSignup failed. Please try again.%s\n", RED, RESET_COLOR);
                 } 
                 else{
                     printf("%sSignup successful! Now you can login with your username and password.%s\n", GREEN, RESET_COLOR);
@@ -111,17 +205,25 @@ int main() {
                 printf("Enter password: ");
                 get_password(password, sizeof(password));
 
-                if (login(username, password, &user_id) == 0) {
+                if (login(username, password, &user_id) == 0 && create_session(user_id, session_token) == 0) {
                     printf("Welcome, %s! (User ID: %d)\n", username, user_id);
+                    start_price_refresher(user_id);
                     int user_choice;
                     while (1) {
                         show_user_menu(user_id);
                         scanf("%d", &user_choice);
                         getchar();
-                        if (user_choice == 9) {
+                        if (user_choice == 13) {
+                            end_session(session_token);
+                            stop_price_refresher();
                             printf("%sLogging out...%s\n", RED, RESET_COLOR);
                             break;
                         }
+                        if (validate_session(session_token, &user_id) != 0) {
+                            stop_price_refresher();
+                            printf("%sSession expired. Please log in again.%s\n", RED, RESET_COLOR);
+                            break;
+                        }
                         switch (user_choice) {
                             case 1:
                                 view_portfolio(user_id);
@@ -140,7 +242,7 @@ int main() {
                                 scanf("%d", &quantity);
                                 getchar(); 
 
-                                double price;
+                                money_t price;
                                 if (fetch_stock_price(symbol, &price) == 0) {
                                     buy_stocks(user_id, symbol, quantity, price);
                                 } else {
@@ -159,7 +261,7 @@ int main() {
                                 scanf("%d", &quantity);
                                 getchar(); 
 
-                                double price;
+                                money_t price;
                                 if (fetch_stock_price(symbol, &price) == 0) {
                                     sell_stocks(user_id, symbol, quantity, price);
                                 } else {
@@ -176,9 +278,10 @@ int main() {
                                 fgets(symbol, sizeof(symbol), stdin);
                                 symbol[strcspn(symbol, "\n")] = 0;
 
-                                double price;
+                                money_t price;
                                 if (fetch_stock_price(symbol, &price) == 0) {
-                                    printf("Current price of %s: $%.2f\n", symbol, price);
+                                    char price_buf[MONEY_STR_LEN];
+                                    printf("Current price of %s: $%s\n", symbol, money_format(price, price_buf));
                                 } else {
                                     printf("Failed to fetch stock price.\n");
                                 }
@@ -193,6 +296,29 @@ int main() {
                                 //     // printf("Failed to fetch user details.\n");
                                 // }
                                 break;
+                            case 9:
+                                view_portfolio_risk(user_id);
+                                break;
+                            case 10: {
+                                char symbol[16];
+                                view_watchlist(user_id);
+                                printf("Symbol to add, -SYMBOL to remove, or Enter to go back: ");
+                                fgets(symbol, sizeof(symbol), stdin);
+                                symbol[strcspn(symbol, "\n")] = 0;
+                                if (symbol[0] == '-') {
+                                    remove_from_watchlist(user_id, symbol + 1);
+                                } else if (symbol[0] != '\0') {
+                                    add_to_watchlist(user_id, symbol);
+                                }
+                                break;
+                            }
+                            case 11:
+                                run_dashboard(user_id);
+                                break;
+                            case 12:
+                                printf("\n%s=== Latency Stats ===%s\n", CYAN, RESET_COLOR);
+                                latency_report(stdout);
+                                break;
                             default:
                                 printf("Invalid option. Please try again.\n");
                         }
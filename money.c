@@ -0,0 +1,106 @@
+#include "money.h"
+#include <stdio.h>
+#include <math.h>
+
+money_t money_from_double(double value) {
+    return (money_t)llround(value * (double)MONEY_SCALE);
+}
+
+double money_to_double(money_t value) {
+    return (double)value / (double)MONEY_SCALE;
+}
+
+int money_parse(const char *text, size_t length, money_t *value) {
+    size_t i = 0;
+    int negative = 0;
+    uint64_t mantissa = 0;
+    int mantissa_digits = 0;
+    int decimal_exponent = 0;
+    int any_digit = 0;
+    int first_dropped = -1;
+    int exponent = 0;
+
+    if (i < length && (text[i] == '-' || text[i] == '+')) {
+        negative = (text[i] == '-');
+        i++;
+    }
+
+    /* Keep 18 significant digits, which always fit in a uint64_t; the first dropped digit decides rounding. */
+    int in_fraction = 0;
+    for (; i < length; i++) {
+        char ch = text[i];
+        if (ch == '.' && !in_fraction) {
+            in_fraction = 1;
+            continue;
+        }
+        if (ch < '0' || ch > '9') break;
+        any_digit = 1;
+        if (mantissa_digits < 18) {
+            if (mantissa != 0 || ch != '0') mantissa_digits++;
+            mantissa = mantissa * 10 + (uint64_t)(ch - '0');
+            if (in_fraction) decimal_exponent--;
+        } else {
+            if (first_dropped < 0) first_dropped = ch - '0';
+            if (!in_fraction) decimal_exponent++;
+        }
+    }
+    if (!any_digit) return -1;
+
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        int exp_negative = 0;
+        i++;
+        if (i < length && (text[i] == '-' || text[i] == '+')) {
+            exp_negative = (text[i] == '-');
+            i++;
+        }
+        if (i >= length || text[i] < '0' || text[i] > '9') return -1;
+        for (; i < length && text[i] >= '0' && text[i] <= '9'; i++) {
+            if (exponent < 1000) exponent = exponent * 10 + (text[i] - '0');
+        }
+        if (exp_negative) exponent = -exponent;
+    }
+    if (i != length) return -1;
+
+    /* mantissa * 10^shift is the value in micro-dollars. */
+    int shift = decimal_exponent + exponent + 6;
+    if (shift >= 0) {
+        if (first_dropped >= 5 && shift == 0) mantissa++;
+        for (; shift > 0; shift--) {
+            if (mantissa > UINT64_MAX / 10) return -1;
+            mantissa *= 10;
+        }
+    } else {
+        int round_digit = first_dropped;
+        for (; shift < 0 && mantissa != 0; shift++) {
+            round_digit = (int)(mantissa % 10);
+            mantissa /= 10;
+        }
+        if (shift < 0) round_digit = 0;
+        if (round_digit >= 5) mantissa++;
+    }
+    if (mantissa > (uint64_t)INT64_MAX) return -1;
+
+    *value = negative ? -(money_t)mantissa : (money_t)mantissa;
+    return 0;
+}
+
+const char *money_format(money_t value, char *buffer) {
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    uint64_t cents = (magnitude + MONEY_SCALE / 200) / (MONEY_SCALE / 100);
+    snprintf(buffer, MONEY_STR_LEN, "%s%llu.%02llu", (value < 0 && cents != 0) ? "-" : "",
+             (unsigned long long)(cents / 100), (unsigned long long)(cents % 100));
+    return buffer;
+}
+
+int money_mul_qty(money_t price, int64_t quantity, money_t *total) {
+    if (__builtin_mul_overflow(price, quantity, total)) return -1;
+    return 0;
+}
+
+money_t money_weighted_average(money_t price_a, int64_t qty_a, money_t price_b, int64_t qty_b) {
+    __int128 total_qty = (__int128)qty_a + qty_b;
+    if (total_qty == 0) return 0;
+    __int128 total = (__int128)price_a * qty_a + (__int128)price_b * qty_b;
+    __int128 half = total_qty / 2;
+    return (money_t)(total >= 0 ? (total + half) / total_qty : (total - half) / total_qty);
+}
@@ -0,0 +1,24 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Money is an exact count of micro-dollars (1 USD == 1,000,000). */
+typedef int64_t money_t;
+
+#define MONEY_SCALE 1000000LL
+#define MONEY_STR_LEN 32
+
+#define MONEY_DOLLARS(d) ((money_t)(d) * MONEY_SCALE)
+
+money_t money_from_double(double value);
+double money_to_double(money_t value);
+
+int money_parse(const char *text, size_t length, money_t *value);
+const char *money_format(money_t value, char *buffer);
+
+int money_mul_qty(money_t price, int64_t quantity, money_t *total);
+money_t money_weighted_average(money_t price_a, int64_t qty_a, money_t price_b, int64_t qty_b);
+
+#endif
@@ -0,0 +1,333 @@
+#include "montecarlo.h"
+#include "timeseries.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Correlated geometric Brownian motion. Under GBM the terminal price only depends
+ * on the sum of the daily shocks, so each path draws its horizon in one step:
+ *   log(S_T / S_0) = (mu - sigma^2 / 2) * T + sqrt(T) * L * z
+ * where L is the Cholesky factor of the daily log-return covariance.
+ *
+ * Normals come from Philox4x32-10 keyed by the seed with the path index as the
+ * counter, so path p gets the same numbers whichever thread runs it and results
+ * do not depend on the thread count.
+ */
+#define MIN_HISTORY 20
+
+void default_risk_config(risk_config *config) {
+    config->paths = 1000000;
+    config->horizon_days = 1;
+    config->history_days = 250;
+    config->threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    config->confidence = 0.99;
+    config->seed = 0x5eed5eedULL;
+}
+
+static void philox4x32_10(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * x0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * x2;
+        uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+        uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+        x0 = y0;
+        x1 = (uint32_t)p1;
+        x2 = y2;
+        x3 = (uint32_t)p0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    out[0] = x0;
+    out[1] = x1;
+    out[2] = x2;
+    out[3] = x3;
+}
+
+/* Fills `count` standard normals for one path using Box-Muller on Philox output. */
+static void path_normals(uint64_t path, const uint32_t key[2], double *z, size_t count) {
+    for (size_t block = 0; block * 4 < count; block++) {
+        uint32_t counter[4] = { (uint32_t)path, (uint32_t)(path >> 32), (uint32_t)block, 0 };
+        uint32_t bits[4];
+        philox4x32_10(counter, key, bits);
+        for (int pair = 0; pair < 2; pair++) {
+            double u1 = ((double)bits[2 * pair] + 1.0) * (1.0 / 4294967297.0);
+            double u2 = (double)bits[2 * pair + 1] * (1.0 / 4294967296.0);
+            double radius = sqrt(-2.0 * log(u1));
+            size_t i = block * 4 + (size_t)pair * 2;
+            if (i < count) z[i] = radius * cos(6.283185307179586 * u2);
+            if (i + 1 < count) z[i + 1] = radius * sin(6.283185307179586 * u2);
+        }
+    }
+}
+
+/* In-place lower Cholesky factor of an n x n row-major matrix; adds jitter if it is not positive definite. */
+static void cholesky(double *a, size_t n) {
+    for (double jitter = 0.0; ; jitter = jitter == 0.0 ? 1e-12 : jitter * 10.0) {
+        double *l = calloc(n * n, sizeof(double));
+        if (l == NULL) return;
+        int ok = 1;
+        for (size_t i = 0; i < n && ok; i++) {
+            for (size_t j = 0; j <= i; j++) {
+                double sum = a[i * n + j] + (i == j ? jitter : 0.0);
+                for (size_t k = 0; k < j; k++) sum -= l[i * n + k] * l[j * n + k];
+                if (i == j) {
+                    if (sum <= 0.0) {
+                        ok = 0;
+                        break;
+                    }
+                    l[i * n + i] = sqrt(sum);
+                } else {
+                    l[i * n + j] = sum / l[j * n + j];
+                }
+            }
+        }
+        if (ok || jitter > 1e-2) {
+            memcpy(a, l, n * n * sizeof(double));
+            free(l);
+            return;
+        }
+        free(l);
+    }
+}
+
+/*
+ * Estimates daily log-return drift and covariance from the stored candles of each
+ * position, using the common tail of their histories. Positions without enough
+ * history get zero drift, a flat fallback volatility and no correlation.
+ */
+static size_t estimate_parameters(const position_buffers *positions, size_t first, size_t n, int history_days,
+                                  double *drift, double *covariance) {
+    candle_series *series = calloc(n, sizeof(candle_series));
+    const money_t **closes = calloc(n, sizeof(money_t *));
+    size_t *lengths = calloc(n, sizeof(size_t));
+    if (series == NULL || closes == NULL || lengths == NULL) {
+        free(series);
+        free(closes);
+        free(lengths);
+        return 0;
+    }
+
+    int64_t since = (int64_t)time(NULL) - (int64_t)history_days * 86400;
+    size_t common = SIZE_MAX;
+    size_t with_history = 0;
+    for (size_t i = 0; i < n; i++) {
+        candle_range range;
+        if (open_candle_series(positions->symbol[first + i], &series[i]) == 0 &&
+            query_candle_range(&series[i], since, INT64_MAX, &range) == 0 && range.count > MIN_HISTORY) {
+            closes[i] = range.close;
+            lengths[i] = range.count;
+            if (range.count < common) common = range.count;
+            with_history++;
+        }
+    }
+
+    size_t samples = with_history ? common - 1 : 0;
+    double *returns = samples ? malloc(n * samples * sizeof(double)) : NULL;
+
+    for (size_t i = 0; i < n; i++) {
+        drift[i] = 0.0;
+        if (returns && closes[i]) {
+            const money_t *tail = closes[i] + lengths[i] - common;
+            double sum = 0.0;
+            for (size_t t = 0; t < samples; t++) {
+                returns[i * samples + t] = log((double)tail[t + 1] / (double)tail[t]);
+                sum += returns[i * samples + t];
+            }
+            drift[i] = sum / samples;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            double cov = 0.0;
+            if (returns && closes[i] && closes[j]) {
+                for (size_t t = 0; t < samples; t++) {
+                    cov += (returns[i * samples + t] - drift[i]) * (returns[j * samples + t] - drift[j]);
+                }
+                cov /= (samples > 1 ? samples - 1 : 1);
+            } else if (i == j) {
+                cov = FALLBACK_DAILY_VOLATILITY * FALLBACK_DAILY_VOLATILITY;
+            }
+            covariance[i * n + j] = cov;
+            covariance[j * n + i] = cov;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        close_candle_series(&series[i]);
+    }
+    free(returns);
+    free(series);
+    free(closes);
+    free(lengths);
+    return with_history;
+}
+
+typedef struct {
+    size_t n;
+    size_t first_path;
+    size_t last_path;
+    uint32_t key[2];
+    const double *start_value;    /* quantity * price per position, in dollars */
+    const double *log_drift;      /* (mu - sigma^2 / 2) * T */
+    const double *factor;         /* sqrt(T) * L */
+    double *pnl;
+    int failed;                   /* set when the worker could not run, leaving its pnl unfilled */
+} risk_worker;
+
+static void *simulate_paths(void *arg) {
+    risk_worker *w = arg;
+    size_t n = w->n;
+    double *z = malloc(n * sizeof(double));
+    if (z == NULL) {
+        w->failed = 1;
+        return NULL;
+    }
+
+    for (size_t p = w->first_path; p < w->last_path; p++) {
+        path_normals(p, w->key, z, n);
+        double pnl = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            double shock = 0.0;
+            for (size_t k = 0; k <= i; k++) shock += w->factor[i * n + k] * z[k];
+            pnl += w->start_value[i] * expm1(w->log_drift[i] + shock);
+        }
+        w->pnl[p] = pnl;
+    }
+
+    free(z);
+    return NULL;
+}
+
+static void swap_double(double *a, double *b) {
+    double t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/* Partially orders values so values[k] is the k-th smallest and everything before it is <= it. */
+static void select_kth(double *values, size_t count, size_t k) {
+    size_t lo = 0, hi = count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (values[mid] < values[lo]) swap_double(&values[mid], &values[lo]);
+        if (values[hi] < values[lo]) swap_double(&values[hi], &values[lo]);
+        if (values[hi] < values[mid]) swap_double(&values[hi], &values[mid]);
+        double pivot = values[mid];
+        size_t i = lo, j = hi;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                swap_double(&values[i], &values[j]);
+                i++;
+                if (j == 0) break;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+}
+
+int simulate_portfolio_risk(const position_buffers *positions, size_t first, size_t count,
+                            const risk_config *config, risk_report *report) {
+    memset(report, 0, sizeof(*report));
+    if (count == 0 || config->paths == 0 || config->horizon_days <= 0) return -1;
+
+    size_t n = count;
+    double *drift = malloc(n * sizeof(double));
+    double *factor = malloc(n * n * sizeof(double));
+    double *start_value = malloc(n * sizeof(double));
+    double *log_drift = malloc(n * sizeof(double));
+    double *pnl = malloc(config->paths * sizeof(double));
+    int threads = config->threads > 0 ? config->threads : 1;
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    risk_worker *workers = malloc(threads * sizeof(risk_worker));
+    if (!drift || !factor || !start_value || !log_drift || !pnl || !ids || !workers) {
+        free(drift); free(factor); free(start_value); free(log_drift); free(pnl); free(ids); free(workers);
+        return -1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    report->symbols_with_history = estimate_parameters(positions, first, n, config->history_days, drift, factor);
+
+    double horizon = (double)config->horizon_days;
+    money_t value = 0;
+    for (size_t i = 0; i < n; i++) {
+        money_t market_value = positions->quantity[first + i] * positions->price[first + i];
+        value += market_value;
+        start_value[i] = money_to_double(market_value);
+        log_drift[i] = (drift[i] - 0.5 * factor[i * n + i]) * horizon;
+    }
+    cholesky(factor, n);
+    for (size_t i = 0; i < n * n; i++) factor[i] *= sqrt(horizon);
+
+    size_t per_thread = (config->paths + threads - 1) / threads;
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        risk_worker *w = &workers[t];
+        w->n = n;
+        w->first_path = (size_t)t * per_thread;
+        w->last_path = w->first_path + per_thread < config->paths ? w->first_path + per_thread : config->paths;
+        w->key[0] = (uint32_t)config->seed;
+        w->key[1] = (uint32_t)(config->seed >> 32);
+        w->start_value = start_value;
+        w->log_drift = log_drift;
+        w->factor = factor;
+        w->pnl = pnl;
+        w->failed = 0;
+        if (w->first_path >= w->last_path) continue;
+        if (pthread_create(&ids[started], NULL, simulate_paths, w) == 0) {
+            started++;
+        } else {
+            simulate_paths(w);
+        }
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    for (int t = 0; t < threads; t++) {
+        if (workers[t].failed) {
+            free(drift); free(factor); free(start_value); free(log_drift); free(pnl); free(ids); free(workers);
+            return -1;
+        }
+    }
+
+    double mean = 0.0;
+    for (size_t p = 0; p < config->paths; p++) mean += pnl[p];
+    mean /= (double)config->paths;
+
+    size_t tail = (size_t)((1.0 - config->confidence) * (double)config->paths);
+    if (tail >= config->paths) tail = config->paths - 1;
+    select_kth(pnl, config->paths, tail);
+    double shortfall = 0.0;
+    for (size_t p = 0; p <= tail; p++) shortfall += pnl[p];
+    shortfall /= (double)(tail + 1);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    report->value = value;
+    report->value_at_risk = money_from_double(-pnl[tail]);
+    report->expected_shortfall = money_from_double(-shortfall);
+    report->mean_pnl = money_from_double(mean);
+    report->paths = config->paths;
+    report->seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    free(drift); free(factor); free(start_value); free(log_drift); free(pnl); free(ids); free(workers);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "analytics.h"
+#include "money.h"
+
+/* Daily volatility assumed for holdings with too little price history. */
+#define FALLBACK_DAILY_VOLATILITY 0.02
+
+typedef struct {
+    size_t paths;
+    int horizon_days;
+    int history_days;      /* daily candles used to estimate drift, volatility and correlation */
+    int threads;
+    double confidence;     /* e.g. 0.99 for 99% VaR */
+    uint64_t seed;
+} risk_config;
+
+typedef struct {
+    money_t value;                 /* current market value of the simulated positions */
+    money_t value_at_risk;         /* loss not exceeded with probability `confidence` */
+    money_t expected_shortfall;    /* mean loss beyond the VaR */
+    money_t mean_pnl;
+    size_t paths;
+    size_t symbols_with_history;
+    double seconds;
+} risk_report;
+
+void default_risk_config(risk_config *config);
+int simulate_portfolio_risk(const position_buffers *positions, size_t first, size_t count,
+                            const risk_config *config, risk_report *report);
+
+#endif
@@ -0,0 +1,246 @@
+#include "quote_cache.h"
+#include "analytics.h"
+#include "database.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <curl/curl.h>
+
+#define DEFAULT_QUOTE_TTL 30
+#define DEFAULT_REFRESH_SECONDS 10
+#define DEFAULT_REFRESH_MAX 5           /* fetches per round: 30 a minute, half the free Finnhub budget */
+
+typedef struct {
+    char symbol[SYMBOL_LEN];
+    stock_quote quote;
+    time_t fetched;
+} quote_entry;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static quote_entry *entries;
+static size_t entry_capacity;
+static size_t entry_count;
+static int notify_pipe[2] = { -1, -1 };
+
+static int env_seconds(const char *name, int fallback) {
+    const char *value = getenv(name);
+    return value != NULL && atoi(value) > 0 ? atoi(value) : fallback;
+}
+
+static size_t symbol_hash(const char *symbol) {
+    size_t h = 5381;
+    for (; *symbol; symbol++) h = h * 33 + (unsigned char)*symbol;
+    return h;
+}
+
+/* The entry for symbol, or the empty slot it belongs in; called with cache_lock held. */
+static quote_entry *find_entry(const char *symbol) {
+    size_t i = symbol_hash(symbol) & (entry_capacity - 1);
+    while (entries[i].symbol[0] != '\0' && strcmp(entries[i].symbol, symbol) != 0) i = (i + 1) & (entry_capacity - 1);
+    return &entries[i];
+}
+
+static int grow_entries(void) {
+    size_t capacity = entry_capacity ? entry_capacity * 2 : 64;
+    quote_entry *old = entries;
+    size_t old_capacity = entry_capacity;
+    quote_entry *grown = calloc(capacity, sizeof(quote_entry));
+    if (grown == NULL) return -1;
+
+    entries = grown;
+    entry_capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].symbol[0] != '\0') *find_entry(old[i].symbol) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+void quote_cache_put(const char *symbol, const stock_quote *quote) {
+    if (symbol[0] == '\0' || strlen(symbol) >= SYMBOL_LEN) return;
+
+    pthread_mutex_lock(&cache_lock);
+    if ((entry_count + 1) * 2 > entry_capacity && grow_entries() != 0) {
+        pthread_mutex_unlock(&cache_lock);
+        return;
+    }
+    quote_entry *entry = find_entry(symbol);
+    if (entry->symbol[0] == '\0') {
+        snprintf(entry->symbol, sizeof(entry->symbol), "%s", symbol);
+        entry_count++;
+    }
+    entry->quote = *quote;
+    entry->fetched = time(NULL);
+    if (notify_pipe[1] >= 0) {
+        /* a full pipe already has a wakeup pending */
+        char byte = 0;
+        ssize_t ignored = write(notify_pipe[1], &byte, 1);
+        (void)ignored;
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+int quote_cache_subscribe(void) {
+    pthread_mutex_lock(&cache_lock);
+    if (notify_pipe[0] < 0 && pipe(notify_pipe) == 0) {
+        fcntl(notify_pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(notify_pipe[1], F_SETFL, O_NONBLOCK);
+    }
+    int fd = notify_pipe[0];
+    pthread_mutex_unlock(&cache_lock);
+    return fd;
+}
+
+int quote_cache_get(const char *symbol, int max_age, stock_quote *quote) {
+    int rc = -1;
+    pthread_mutex_lock(&cache_lock);
+    if (entry_capacity > 0) {
+        quote_entry *entry = find_entry(symbol);
+        if (entry->symbol[0] != '\0' && time(NULL) - entry->fetched <= max_age) {
+            *quote = entry->quote;
+            rc = 0;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return rc;
+}
+
+int cached_stock_quote(const char *symbol, stock_quote *quote) {
+    if (quote_cache_get(symbol, env_seconds("STOCKSIM_QUOTE_TTL", DEFAULT_QUOTE_TTL), quote) == 0) return 0;
+    if (fetch_stock_quote(symbol, quote) != 0) return -1;
+    quote_cache_put(symbol, quote);
+    return 0;
+}
+
+/*
+ * The refresher. It re-reads the symbol list every round, so trades and
+ * watchlist edits are picked up without telling it.
+ */
+static pthread_mutex_t refresher_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t refresher_wake = PTHREAD_COND_INITIALIZER;
+static pthread_t refresher_thread;
+static int refresher_running;
+static atomic_int refresher_stop;       /* also polled by in-flight transfers */
+static int refresher_user;
+static atomic_ulong refresh_failures;
+
+static int load_refresh_symbols(int user_id, char (**symbols)[SYMBOL_LEN], size_t *count) {
+    *symbols = NULL;
+    *count = 0;
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+
+    const char *sql = "SELECT stock_symbol FROM portfolio WHERE user_id = ? "
+                      "UNION SELECT stock_symbol FROM watchlist WHERE user_id = ?;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare refresh query: %s\n", sqlite3_errmsg(db));
+        close_database(db);
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_int(stmt, 2, user_id);
+
+    size_t capacity = 0;
+    int rc = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 32;
+            char (*grown)[SYMBOL_LEN] = realloc(*symbols, capacity * SYMBOL_LEN);
+            if (grown == NULL) {
+                rc = -1;
+                break;
+            }
+            *symbols = grown;
+        }
+        snprintf((*symbols)[(*count)++], SYMBOL_LEN, "%s", (const char *)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    close_database(db);
+    return rc;
+}
+
+static void *refresher_main(void *arg) {
+    (void)arg;
+    api_set_abort_flag(&refresher_stop);
+    /* errors printed from here would land in the middle of a menu prompt or the dashboard */
+    api_set_quiet(1);
+    int interval = env_seconds("STOCKSIM_REFRESH_SECONDS", DEFAULT_REFRESH_SECONDS);
+    int max_fetches = env_seconds("STOCKSIM_REFRESH_MAX", DEFAULT_REFRESH_MAX);
+    size_t cursor = 0;          /* where the next round starts, so a capped round doesn't starve the tail */
+
+    pthread_mutex_lock(&refresher_lock);
+    while (!refresher_stop) {
+        int user_id = refresher_user;
+        pthread_mutex_unlock(&refresher_lock);
+
+        char (*symbols)[SYMBOL_LEN];
+        size_t count;
+        if (load_refresh_symbols(user_id, &symbols, &count) == 0 && count > 0) {
+            int fetches = 0;
+            size_t seen = 0;
+            for (; seen < count && fetches < max_fetches && !refresher_stop; seen++) {
+                const char *symbol = symbols[(cursor + seen) % count];
+                stock_quote quote;
+                /* fetched (by anyone) within the last interval: still fresh */
+                if (quote_cache_get(symbol, interval - 1, &quote) == 0) continue;
+                fetches++;
+                if (fetch_stock_quote(symbol, &quote) == 0) quote_cache_put(symbol, &quote);
+                else refresh_failures++;
+            }
+            cursor = (cursor + seen) % count;
+        }
+        free(symbols);
+
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += interval;
+        pthread_mutex_lock(&refresher_lock);
+        while (!refresher_stop && pthread_cond_timedwait(&refresher_wake, &refresher_lock, &until) == 0) {}
+    }
+    pthread_mutex_unlock(&refresher_lock);
+    return NULL;
+}
+
+unsigned long quote_refresh_failures(void) {
+    return refresh_failures;
+}
+
+/* Starts refreshing for user_id, replacing any refresher already running. */
+int start_price_refresher(int user_id) {
+    stop_price_refresher();
+
+    /* curl's global setup is not thread-safe; do it before a second thread can fetch */
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    pthread_mutex_lock(&refresher_lock);
+    refresher_user = user_id;
+    refresher_stop = 0;
+    refresher_running = pthread_create(&refresher_thread, NULL, refresher_main, NULL) == 0;
+    pthread_mutex_unlock(&refresher_lock);
+    if (!refresher_running) {
+        fprintf(stderr, "Failed to start the price refresher.\n");
+        return -1;
+    }
+    return 0;
+}
+
+void stop_price_refresher(void) {
+    pthread_mutex_lock(&refresher_lock);
+    if (!refresher_running) {
+        pthread_mutex_unlock(&refresher_lock);
+        return;
+    }
+    refresher_stop = 1;
+    pthread_cond_broadcast(&refresher_wake);
+    pthread_mutex_unlock(&refresher_lock);
+
+    pthread_join(refresher_thread, NULL);
+    pthread_mutex_lock(&refresher_lock);
+    refresher_running = 0;
+    pthread_mutex_unlock(&refresher_lock);
+}
@@ -0,0 +1,30 @@
+#ifndef QUOTE_CACHE_H
+#define QUOTE_CACHE_H
+
+#include "api.h"
+
+/*
+ * Recent quotes by symbol, shared between threads. cached_stock_quote()
+ * answers from the cache while an entry is younger than the TTL
+ * (STOCKSIM_QUOTE_TTL seconds, default 30) and fetches otherwise. The price
+ * refresher is a background thread started at login: every
+ * STOCKSIM_REFRESH_SECONDS (default 10) it re-fetches the user's holdings and
+ * watchlist into the cache, so portfolio views are served without waiting on
+ * the network. A round skips quotes younger than the interval and fetches at
+ * most STOCKSIM_REFRESH_MAX (default 5), resuming where the last round
+ * stopped; its fetch errors are counted rather than printed.
+ */
+int cached_stock_quote(const char *symbol, stock_quote *quote);
+void quote_cache_put(const char *symbol, const stock_quote *quote);
+/* 0 and the quote when an entry at most max_age seconds old exists. */
+int quote_cache_get(const char *symbol, int max_age, stock_quote *quote);
+
+/* A file descriptor that becomes readable whenever a quote is stored; drain it after waking. */
+int quote_cache_subscribe(void);
+
+int start_price_refresher(int user_id);
+void stop_price_refresher(void);
+/* Background fetches that failed since the program started. */
+unsigned long quote_refresh_failures(void);
+
+#endif
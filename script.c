@@ -0,0 +1,253 @@
+#include "script.h"
+#include "database.h"
+#include "auth.h"
+#include "api.h"
+#include "latency.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ARGS 4
+
+typedef struct {
+    int logged_in;
+    int user_id;
+    char token[SESSION_TOKEN_LEN + 1];
+} script_session;
+
+typedef struct {
+    const char *name;
+    int args;                   /* required argument count */
+    int needs_login;
+    const char *usage;
+    int (*run)(script_session *session, char **argv, char *detail, size_t size);
+} script_command;
+
+static int run_signup(script_session *session, char **argv, char *detail, size_t size) {
+    (void)session;
+    int rc = signup(argv[0], argv[1]);
+    if (rc == AUTH_TAKEN) snprintf(detail, size, "username taken");
+    else if (rc == AUTH_BUSY) snprintf(detail, size, "busy");
+    return rc == 0 ? 0 : -1;
+}
+
+static int run_login(script_session *session, char **argv, char *detail, size_t size) {
+    int user_id;
+    if (session->logged_in) {
+        end_session(session->token);
+        session->logged_in = 0;
+    }
+    int rc = login(argv[0], argv[1], &user_id);
+    if (rc == 0 && create_session(user_id, session->token) == 0) {
+        session->logged_in = 1;
+        session->user_id = user_id;
+        snprintf(detail, size, "%d", user_id);
+        return 0;
+    }
+    snprintf(detail, size, rc == AUTH_BUSY ? "busy" : "invalid credentials");
+    return -1;
+}
+
+static int run_logout(script_session *session, char **argv, char *detail, size_t size) {
+    (void)argv;
+    (void)detail;
+    (void)size;
+    end_session(session->token);
+    session->logged_in = 0;
+    return 0;
+}
+
+static int run_price(script_session *session, char **argv, char *detail, size_t size) {
+    (void)session;
+    money_t price;
+    if (fetch_stock_price(argv[0], &price) != 0) {
+        snprintf(detail, size, "no quote");
+        return -1;
+    }
+    char price_buf[MONEY_STR_LEN];
+    snprintf(detail, size, "%s", money_format(price, price_buf));
+    return 0;
+}
+
+static int run_trade(script_session *session, char **argv, char *detail, size_t size, int buy) {
+    char *end;
+    long quantity = strtol(argv[1], &end, 10);
+    if (*end != '\0' || quantity <= 0 || quantity > 1000000000L) {
+        snprintf(detail, size, "bad quantity");
+        return -1;
+    }
+    money_t price;
+    if (fetch_stock_price(argv[0], &price) != 0) {
+        snprintf(detail, size, "no quote");
+        return -1;
+    }
+    char price_buf[MONEY_STR_LEN];
+    snprintf(detail, size, "%s", money_format(price, price_buf));
+    return buy ? buy_stocks(session->user_id, argv[0], (int)quantity, price)
+               : sell_stocks(session->user_id, argv[0], (int)quantity, price);
+}
+
+static int run_buy(script_session *session, char **argv, char *detail, size_t size) {
+    return run_trade(session, argv, detail, size, 1);
+}
+
+static int run_sell(script_session *session, char **argv, char *detail, size_t size) {
+    return run_trade(session, argv, detail, size, 0);
+}
+
+static int run_portfolio(script_session *session, char **argv, char *detail, size_t size) {
+    (void)argv;
+    (void)detail;
+    (void)size;
+    return view_portfolio(session->user_id);
+}
+
+static int run_risk(script_session *session, char **argv, char *detail, size_t size) {
+    (void)argv;
+    (void)detail;
+    (void)size;
+    return view_portfolio_risk(session->user_id);
+}
+
+static int run_transactions(script_session *session, char **argv, char *detail, size_t size) {
+    (void)argv;
+    (void)detail;
+    (void)size;
+    return view_transactions(session->user_id);
+}
+
+static int run_profile(script_session *session, char **argv, char *detail, size_t size) {
+    (void)argv;
+    (void)detail;
+    (void)size;
+    view_user_details(session->user_id);
+    return 0;
+}
+
+static int run_leaderboard(script_session *session, char **argv, char *detail, size_t size) {
+    (void)session;
+    (void)argv;
+    (void)detail;
+    (void)size;
+    view_leaderboard();
+    return 0;
+}
+
+static int run_stocks(script_session *session, char **argv, char *detail, size_t size) {
+    (void)session;
+    (void)argv;
+    (void)detail;
+    (void)size;
+    return fetch_stock_details("US");
+}
+
+static int run_watch(script_session *session, char **argv, char *detail, size_t size) {
+    (void)detail;
+    (void)size;
+    return add_to_watchlist(session->user_id, argv[0]);
+}
+
+static int run_unwatch(script_session *session, char **argv, char *detail, size_t size) {
+    (void)detail;
+    (void)size;
+    return remove_from_watchlist(session->user_id, argv[0]);
+}
+
+static int run_watchlist(script_session *session, char **argv, char *detail, size_t size) {
+    (void)argv;
+    (void)detail;
+    (void)size;
+    return view_watchlist(session->user_id);
+}
+
+static int run_stats(script_session *session, char **argv, char *detail, size_t size) {
+    (void)session;
+    (void)argv;
+    (void)detail;
+    (void)size;
+    latency_report(stdout);
+    return 0;
+}
+
+static int run_stats_dump(script_session *session, char **argv, char *detail, size_t size) {
+    (void)session;
+    if (latency_dump(argv[0]) != 0) {
+        snprintf(detail, size, "cannot write %s", argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+static const script_command commands[] = {
+    { "signup", 2, 0, "signup USER PASS", run_signup },
+    { "login", 2, 0, "login USER PASS", run_login },
+    { "logout", 0, 1, "logout", run_logout },
+    { "price", 1, 0, "price SYMBOL", run_price },
+    { "buy", 2, 1, "buy SYMBOL QTY", run_buy },
+    { "sell", 2, 1, "sell SYMBOL QTY", run_sell },
+    { "portfolio", 0, 1, "portfolio", run_portfolio },
+    { "risk", 0, 1, "risk", run_risk },
+    { "transactions", 0, 1, "transactions", run_transactions },
+    { "profile", 0, 1, "profile", run_profile },
+    { "watch", 1, 1, "watch SYMBOL", run_watch },
+    { "unwatch", 1, 1, "unwatch SYMBOL", run_unwatch },
+    { "watchlist", 0, 1, "watchlist", run_watchlist },
+    { "leaderboard", 0, 0, "leaderboard", run_leaderboard },
+    { "stocks", 0, 0, "stocks", run_stocks },
+    { "stats", 0, 0, "stats", run_stats },
+    { "stats-dump", 1, 0, "stats-dump FILE", run_stats_dump },
+};
+
+static const script_command *find_command(const char *name) {
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(commands[i].name, name) == 0) return &commands[i];
+    }
+    return NULL;
+}
+
+int run_script(FILE *in, FILE *records) {
+    script_session session = { 0 };
+    char line[512];
+    int line_number = 0, executed = 0, failed = 0;
+    double total = 0.0;
+
+    fprintf(records, "line\tcommand\tstatus\tms\tdetail\n");
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line_number++;
+        char *argv[MAX_ARGS + 1];
+        int argc = 0;
+        char *save;
+        for (char *word = strtok_r(line, " \t\r\n", &save); word != NULL; word = strtok_r(NULL, " \t\r\n", &save)) {
+            if (argc <= MAX_ARGS) argv[argc] = word;
+            argc++;
+        }
+        if (argc == 0 || argv[0][0] == '#') continue;
+
+        const script_command *command = find_command(argv[0]);
+        char detail[128] = "";
+        int rc = -1;
+        uint64_t start = latency_now();
+        if (command == NULL) {
+            snprintf(detail, sizeof(detail), "unknown command");
+        } else if (argc - 1 != command->args) {
+            snprintf(detail, sizeof(detail), "usage: %s", command->usage);
+        } else if (command->needs_login &&
+                   (!session.logged_in || validate_session(session.token, &session.user_id) != 0)) {
+            session.logged_in = 0;
+            snprintf(detail, sizeof(detail), "not logged in");
+        } else {
+            rc = command->run(&session, argv + 1, detail, sizeof(detail));
+        }
+        double elapsed = (double)(latency_now() - start) / 1e9;
+        fflush(stdout);
+
+        executed++;
+        total += elapsed;
+        if (rc != 0) failed++;
+        fprintf(records, "%d\t%s\t%s\t%.3f\t%s\n", line_number, argv[0], rc == 0 ? "ok" : "error", elapsed * 1e3, detail);
+        fflush(records);
+    }
+
+    if (session.logged_in) end_session(session.token);
+    fprintf(stderr, "%d commands, %d failed, %.3f ms\n", executed, failed, total * 1e3);
+    return failed;
+}
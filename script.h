@@ -0,0 +1,28 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stdio.h>
+
+/*
+ * Batch mode: runs one command per line of `in` through the same functions
+ * as the menus, and writes one tab-separated record per command to
+ * `records`:
+ *
+ *   line  command  status  ms  detail
+ *
+ * status is "ok" or "error"; detail is the price for price/buy/sell, the
+ * user id for login, or the reason a command failed. The human-readable
+ * output of each command goes to stdout as usual, so callers point stdout
+ * somewhere else (main -s sends it to stderr).
+ *
+ * Commands: signup USER PASS, login USER PASS, logout, price SYMBOL,
+ * buy SYMBOL QTY, sell SYMBOL QTY, portfolio, risk, transactions, profile,
+ * watch SYMBOL, unwatch SYMBOL, watchlist, leaderboard, stocks, stats
+ * (the latency report) and stats-dump FILE (the raw histograms). Blank
+ * lines and lines starting with # are skipped.
+ *
+ * Returns the number of failed commands.
+ */
+int run_script(FILE *in, FILE *records);
+
+#endif
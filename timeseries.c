@@ -0,0 +1,236 @@
+#include "timeseries.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Each symbol is stored as six flat files of native int64 values, one per column
+ * (CANDLE_DIR/AAPL.t, AAPL.o, AAPL.h, AAPL.l, AAPL.c, AAPL.v), sorted by timestamp.
+ * Prices are money_t micro-dollars. Readers map the files and binary search the
+ * timestamp column, so a range query only faults in the pages it returns.
+ */
+static const char *column_suffix[CANDLE_COLUMN_COUNT] = { "t", "o", "h", "l", "c", "v" };
+
+static int valid_symbol(const char *symbol) {
+    size_t len = strlen(symbol);
+    if (len == 0 || len >= sizeof(((candle_series *)0)->symbol)) return 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)symbol[i];
+        if (!isalnum(ch) && ch != '.' && ch != '-' && ch != '_' && ch != '^') return 0;
+    }
+    return 1;
+}
+
+static void column_path(const char *symbol, int column, char *path, size_t size) {
+    snprintf(path, size, "%s/%s.%s", CANDLE_DIR, symbol, column_suffix[column]);
+}
+
+int open_candle_series(const char *symbol, candle_series *series) {
+    memset(series, 0, sizeof(*series));
+    if (!valid_symbol(symbol)) {
+        fprintf(stderr, "Invalid symbol: %s\n", symbol);
+        return -1;
+    }
+    strcpy(series->symbol, symbol);
+
+    int fds[CANDLE_COLUMN_COUNT];
+    size_t count = SIZE_MAX;
+    for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+        char path[256];
+        column_path(symbol, col, path, sizeof(path));
+        fds[col] = open(path, O_RDONLY);
+        struct stat st;
+        if (fds[col] < 0 || fstat(fds[col], &st) != 0) {
+            count = 0;
+            continue;
+        }
+        size_t rows = (size_t)st.st_size / sizeof(int64_t);
+        if (rows < count) count = rows;
+    }
+
+    int rc = 0;
+    if (count > 0) {
+        for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+            size_t size = count * sizeof(int64_t);
+            void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fds[col], 0);
+            if (map == MAP_FAILED) {
+                fprintf(stderr, "Failed to map %s candles: %s\n", symbol, strerror(errno));
+                rc = -1;
+                break;
+            }
+            madvise(map, size, MADV_RANDOM);
+            series->columns[col] = map;
+            series->mapped_size[col] = size;
+        }
+    }
+
+    for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+        if (fds[col] >= 0) close(fds[col]);
+    }
+
+    if (rc != 0) {
+        close_candle_series(series);
+        return -1;
+    }
+    series->count = count;
+    return 0;
+}
+
+void close_candle_series(candle_series *series) {
+    for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+        if (series->columns[col]) {
+            munmap(series->columns[col], series->mapped_size[col]);
+            series->columns[col] = NULL;
+            series->mapped_size[col] = 0;
+        }
+    }
+    series->count = 0;
+}
+
+static size_t lower_bound(const int64_t *timestamps, size_t count, int64_t value) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (timestamps[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void prefetch_rows(const void *column, size_t first, size_t count) {
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)((const int64_t *)column + first);
+    uintptr_t end = start + count * sizeof(int64_t);
+    start &= ~(uintptr_t)(page - 1);
+    madvise((void *)start, end - start, MADV_WILLNEED);
+}
+
+int query_candle_range(const candle_series *series, int64_t from, int64_t to, candle_range *range) {
+    memset(range, 0, sizeof(*range));
+    if (series->count == 0 || from > to) return 0;
+
+    const int64_t *timestamps = series->columns[CANDLE_COLUMN_TIMESTAMP];
+    size_t first = lower_bound(timestamps, series->count, from);
+    size_t last = (to == INT64_MAX) ? series->count : lower_bound(timestamps, series->count, to + 1);
+    if (first >= last) return 0;
+
+    range->count = last - first;
+    for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+        prefetch_rows(series->columns[col], first, range->count);
+    }
+    range->timestamp = (const int64_t *)series->columns[CANDLE_COLUMN_TIMESTAMP] + first;
+    range->open = (const money_t *)series->columns[CANDLE_COLUMN_OPEN] + first;
+    range->high = (const money_t *)series->columns[CANDLE_COLUMN_HIGH] + first;
+    range->low = (const money_t *)series->columns[CANDLE_COLUMN_LOW] + first;
+    range->close = (const money_t *)series->columns[CANDLE_COLUMN_CLOSE] + first;
+    range->volume = (const int64_t *)series->columns[CANDLE_COLUMN_VOLUME] + first;
+    return 0;
+}
+
+static int write_all(int fd, const void *data, size_t size) {
+    const char *p = data;
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+int append_candles(const char *symbol, const candle_t *candles, size_t count) {
+    if (!valid_symbol(symbol)) {
+        fprintf(stderr, "Invalid symbol: %s\n", symbol);
+        return -1;
+    }
+    if (mkdir(CANDLE_DIR, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s: %s\n", CANDLE_DIR, strerror(errno));
+        return -1;
+    }
+
+    int fds[CANDLE_COLUMN_COUNT];
+    size_t rows = SIZE_MAX;
+    int rc = 0;
+    for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+        char path[256];
+        column_path(symbol, col, path, sizeof(path));
+        fds[col] = open(path, O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if (fds[col] < 0 || fstat(fds[col], &st) != 0) {
+            fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+            rc = -1;
+            continue;
+        }
+        size_t column_rows = (size_t)st.st_size / sizeof(int64_t);
+        if (column_rows < rows) rows = column_rows;
+    }
+
+    /* An interrupted append can leave columns of different lengths; cut them back to the common prefix. */
+    int64_t last_timestamp = INT64_MIN;
+    if (rc == 0) {
+        for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+            if (ftruncate(fds[col], (off_t)(rows * sizeof(int64_t))) != 0) rc = -1;
+        }
+        if (rows > 0 && pread(fds[CANDLE_COLUMN_TIMESTAMP], &last_timestamp, sizeof(last_timestamp),
+                              (off_t)((rows - 1) * sizeof(int64_t))) != (ssize_t)sizeof(last_timestamp)) {
+            rc = -1;
+        }
+    }
+
+    int64_t *buffer = (rc == 0 && count > 0) ? malloc(count * sizeof(int64_t)) : NULL;
+    if (rc == 0 && count > 0 && buffer == NULL) rc = -1;
+
+    /* Only candles newer than the stored tail are appended, which makes re-ingesting an overlapping window a no-op. */
+    size_t first = 0;
+    while (first < count && candles[first].timestamp <= last_timestamp) first++;
+
+    for (int col = 0; rc == 0 && first < count && col < CANDLE_COLUMN_COUNT; col++) {
+        size_t n = 0;
+        int64_t previous = last_timestamp;
+        for (size_t i = first; i < count; i++) {
+            if (candles[i].timestamp <= previous) continue;
+            previous = candles[i].timestamp;
+            switch (col) {
+                case CANDLE_COLUMN_TIMESTAMP: buffer[n++] = candles[i].timestamp; break;
+                case CANDLE_COLUMN_OPEN: buffer[n++] = candles[i].open; break;
+                case CANDLE_COLUMN_HIGH: buffer[n++] = candles[i].high; break;
+                case CANDLE_COLUMN_LOW: buffer[n++] = candles[i].low; break;
+                case CANDLE_COLUMN_CLOSE: buffer[n++] = candles[i].close; break;
+                case CANDLE_COLUMN_VOLUME: buffer[n++] = candles[i].volume; break;
+            }
+        }
+        if (lseek(fds[col], 0, SEEK_END) < 0 || write_all(fds[col], buffer, n * sizeof(int64_t)) != 0) {
+            fprintf(stderr, "Failed to append %s candles: %s\n", symbol, strerror(errno));
+            rc = -1;
+        }
+    }
+
+    free(buffer);
+    for (int col = 0; col < CANDLE_COLUMN_COUNT; col++) {
+        if (fds[col] >= 0) close(fds[col]);
+    }
+    return rc;
+}
+
+int ingest_candles(const char *symbol, const char *resolution, int64_t from, int64_t to) {
+    candle_t *candles = NULL;
+    size_t count = 0;
+    if (fetch_stock_candles(symbol, resolution, from, to, &candles, &count) != 0) {
+        return -1;
+    }
+    int rc = append_candles(symbol, candles, count);
+    free(candles);
+    return rc;
+}
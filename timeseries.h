@@ -0,0 +1,46 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "api.h"
+
+#define CANDLE_DIR "candles"
+
+enum {
+    CANDLE_COLUMN_TIMESTAMP,
+    CANDLE_COLUMN_OPEN,
+    CANDLE_COLUMN_HIGH,
+    CANDLE_COLUMN_LOW,
+    CANDLE_COLUMN_CLOSE,
+    CANDLE_COLUMN_VOLUME,
+    CANDLE_COLUMN_COUNT
+};
+
+/* A read-only, memory-mapped view of every candle stored for one symbol. */
+typedef struct {
+    char symbol[16];
+    size_t count;
+    void *columns[CANDLE_COLUMN_COUNT];
+    size_t mapped_size[CANDLE_COLUMN_COUNT];
+} candle_series;
+
+/* Column pointers into a candle_series for candles with from <= timestamp <= to. */
+typedef struct {
+    size_t count;
+    const int64_t *timestamp;
+    const money_t *open;
+    const money_t *high;
+    const money_t *low;
+    const money_t *close;
+    const int64_t *volume;
+} candle_range;
+
+int open_candle_series(const char *symbol, candle_series *series);
+void close_candle_series(candle_series *series);
+int query_candle_range(const candle_series *series, int64_t from, int64_t to, candle_range *range);
+
+int append_candles(const char *symbol, const candle_t *candles, size_t count);
+int ingest_candles(const char *symbol, const char *resolution, int64_t from, int64_t to);
+
+#endif
@@ -0,0 +1,37 @@
+#include "trade.h"
+
+/*
+ * Trade rules shared by the SQLite ledger in database.c and the in-memory
+ * ledger in backtest.c, so a backtest fills orders exactly like the CLI does.
+ */
+int check_buy(money_t cash, int quantity, money_t price, money_t *cost) {
+    if (quantity <= 0 || price < 0 || money_mul_qty(price, quantity, cost) != 0) {
+        return TRADE_INVALID_ORDER;
+    }
+    if (cash < *cost) {
+        return TRADE_INSUFFICIENT_FUNDS;
+    }
+    return TRADE_OK;
+}
+
+int check_sell(int held_quantity, int quantity, money_t price, money_t *revenue) {
+    if (quantity <= 0 || price < 0 || money_mul_qty(price, quantity, revenue) != 0) {
+        return TRADE_INVALID_ORDER;
+    }
+    if (held_quantity < quantity) {
+        return TRADE_INSUFFICIENT_SHARES;
+    }
+    return TRADE_OK;
+}
+
+void apply_buy(holding *position, int quantity, money_t price) {
+    position->average_price = money_weighted_average(position->average_price, position->quantity, price, quantity);
+    position->quantity += quantity;
+}
+
+void apply_sell(holding *position, int quantity) {
+    position->quantity -= quantity;
+    if (position->quantity == 0) {
+        position->average_price = 0;
+    }
+}
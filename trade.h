@@ -0,0 +1,27 @@
+#ifndef TRADE_H
+#define TRADE_H
+
+#include "money.h"
+
+#define STARTING_CASH MONEY_DOLLARS(10000)
+
+enum {
+    TRADE_OK = 0,
+    TRADE_INVALID_ORDER = -1,
+    TRADE_INSUFFICIENT_FUNDS = -2,
+    TRADE_INSUFFICIENT_SHARES = -3
+};
+
+/* One symbol's position: share count and average purchase price. */
+typedef struct {
+    int quantity;
+    money_t average_price;
+} holding;
+
+int check_buy(money_t cash, int quantity, money_t price, money_t *cost);
+int check_sell(int held_quantity, int quantity, money_t price, money_t *revenue);
+
+void apply_buy(holding *position, int quantity, money_t price);
+void apply_sell(holding *position, int quantity);
+
+#endif
@@ -0,0 +1,227 @@
+#include "username_index.h"
+#include "database.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define BLOOM_HASHES 7
+#define BLOOM_BITS_PER_NAME 10
+#define MIN_BLOOM_BITS (1u << 20)
+
+typedef struct {
+    uint64_t hash;
+    char *name;
+} name_slot;
+
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+static username_index_mode index_mode;
+static size_t name_count;
+
+static name_slot *slots;
+static size_t slot_capacity;
+
+static uint64_t *bloom;
+static uint64_t bloom_mask;     /* bit count - 1 */
+static size_t bloom_capacity;   /* names the filter was sized for */
+
+static uint64_t hash_name(const char *name) {
+    uint64_t h = 1469598103934665603ULL;
+    for (; *name; name++) {
+        h ^= (unsigned char)*name;
+        h *= 1099511628211ULL;
+    }
+    /* finalizer so the low bits used for indexing depend on every byte */
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static name_slot *find_slot(uint64_t hash, const char *name) {
+    size_t i = (size_t)hash & (slot_capacity - 1);
+    while (slots[i].name != NULL && (slots[i].hash != hash || strcmp(slots[i].name, name) != 0)) {
+        i = (i + 1) & (slot_capacity - 1);
+    }
+    return &slots[i];
+}
+
+static int grow_slots(void) {
+    size_t capacity = slot_capacity ? slot_capacity * 2 : 1024;
+    name_slot *old = slots;
+    size_t old_capacity = slot_capacity;
+    name_slot *grown = calloc(capacity, sizeof(name_slot));
+    if (grown == NULL) return -1;
+
+    slots = grown;
+    slot_capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].name != NULL) *find_slot(old[i].hash, old[i].name) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+static void set_add(uint64_t hash, const char *name) {
+    if ((name_count + 1) * 2 > slot_capacity && grow_slots() != 0) return;
+    name_slot *slot = find_slot(hash, name);
+    if (slot->name != NULL) return;
+    slot->name = strdup(name);
+    if (slot->name == NULL) return;
+    slot->hash = hash;
+    name_count++;
+}
+
+/* Kirsch-Mitzenmacher: the k probes are h1 + i * h2 from the two halves of one hash. */
+static void bloom_add(uint64_t hash) {
+    uint64_t h1 = hash & 0xffffffffu, h2 = (hash >> 32) | 1;
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        uint64_t bit = (h1 + (uint64_t)i * h2) & bloom_mask;
+        bloom[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+static int bloom_maybe(uint64_t hash) {
+    uint64_t h1 = hash & 0xffffffffu, h2 = (hash >> 32) | 1;
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        uint64_t bit = (h1 + (uint64_t)i * h2) & bloom_mask;
+        if (!(bloom[bit >> 6] & (1ULL << (bit & 63)))) return 0;
+    }
+    return 1;
+}
+
+static int size_bloom(size_t names) {
+    uint64_t bits = MIN_BLOOM_BITS;
+    while (bits < (uint64_t)names * BLOOM_BITS_PER_NAME) bits *= 2;
+    uint64_t *filter = calloc(bits / 64, sizeof(uint64_t));
+    if (filter == NULL) return -1;
+    bloom = filter;
+    bloom_mask = bits - 1;
+    bloom_capacity = bits / BLOOM_BITS_PER_NAME;
+    return 0;
+}
+
+static void clear_index(void) {
+    for (size_t i = 0; i < slot_capacity; i++) free(slots[i].name);
+    free(slots);
+    free(bloom);
+    slots = NULL;
+    bloom = NULL;
+    slot_capacity = 0;
+    bloom_mask = 0;
+    bloom_capacity = 0;
+    name_count = 0;
+    index_mode = USERNAME_INDEX_OFF;
+}
+
+/* Called with index_lock held. */
+static int load_locked(username_index_mode mode) {
+    clear_index();
+    if (mode == USERNAME_INDEX_OFF) return 0;
+
+    sqlite3 *db = open_database();
+    if (!db) return -1;
+
+    sqlite3_stmt *stmt;
+    size_t users = 0;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM users;", -1, &stmt, 0) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) users = (size_t)sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    /* room for the table to double before the filter needs rebuilding */
+    if (mode == USERNAME_INDEX_BLOOM && size_bloom(users * 2) != 0) {
+        close_database(db);
+        return -1;
+    }
+
+    if (sqlite3_prepare_v2(db, "SELECT username FROM users;", -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        close_database(db);
+        clear_index();
+        return -1;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *name = (const char *)sqlite3_column_text(stmt, 0);
+        if (name == NULL) continue;
+        uint64_t hash = hash_name(name);
+        if (mode == USERNAME_INDEX_BLOOM) {
+            bloom_add(hash);
+            name_count++;
+        } else {
+            set_add(hash, name);
+        }
+    }
+    sqlite3_finalize(stmt);
+    close_database(db);
+
+    index_mode = mode;
+    return 0;
+}
+
+int load_username_index(username_index_mode mode) {
+    pthread_mutex_lock(&index_lock);
+    int rc = load_locked(mode);
+    pthread_mutex_unlock(&index_lock);
+    return rc;
+}
+
+int init_username_index(void) {
+    const char *env = getenv("STOCKSIM_USERNAME_INDEX");
+    username_index_mode mode = USERNAME_INDEX_SET;
+    if (env != NULL && strcmp(env, "bloom") == 0) mode = USERNAME_INDEX_BLOOM;
+    else if (env != NULL && strcmp(env, "off") == 0) mode = USERNAME_INDEX_OFF;
+    return load_username_index(mode);
+}
+
+/* A possible Bloom hit is settled by the users table, through one connection kept for it. */
+static sqlite3 *confirm_db;
+static sqlite3_stmt *confirm_stmt;
+
+static int confirm_taken(const char *username) {
+    if (confirm_stmt == NULL) {
+        if (confirm_db == NULL && (confirm_db = open_database()) == NULL) return 0;
+        if (sqlite3_prepare_v2(confirm_db, "SELECT 1 FROM users WHERE username = ?;", -1, &confirm_stmt, 0) != SQLITE_OK) {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(confirm_db));
+            return 0;
+        }
+    }
+    sqlite3_bind_text(confirm_stmt, 1, username, -1, SQLITE_STATIC);
+    int taken = sqlite3_step(confirm_stmt) == SQLITE_ROW;
+    sqlite3_reset(confirm_stmt);
+    return taken;
+}
+
+int username_taken(const char *username) {
+    uint64_t hash = hash_name(username);
+    pthread_mutex_lock(&index_lock);
+    int taken = 0;
+    if (index_mode == USERNAME_INDEX_SET) {
+        taken = slot_capacity > 0 && find_slot(hash, username)->name != NULL;
+    } else if (index_mode == USERNAME_INDEX_BLOOM && bloom_maybe(hash)) {
+        taken = confirm_taken(username);
+    }
+    pthread_mutex_unlock(&index_lock);
+    return taken;
+}
+
+void add_username(const char *username) {
+    uint64_t hash = hash_name(username);
+    pthread_mutex_lock(&index_lock);
+    if (index_mode == USERNAME_INDEX_SET) {
+        set_add(hash, username);
+    } else if (index_mode == USERNAME_INDEX_BLOOM) {
+        bloom_add(hash);
+        name_count++;
+        /* past its sizing the false-positive rate climbs; rebuild from the table */
+        if (name_count > bloom_capacity) load_locked(USERNAME_INDEX_BLOOM);
+    }
+    pthread_mutex_unlock(&index_lock);
+}
+
+size_t username_index_size(void) {
+    pthread_mutex_lock(&index_lock);
+    size_t count = name_count;
+    pthread_mutex_unlock(&index_lock);
+    return count;
+}
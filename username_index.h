@@ -0,0 +1,26 @@
+#ifndef USERNAME_INDEX_H
+#define USERNAME_INDEX_H
+
+#include <stddef.h>
+
+/*
+ * Every username in the users table, kept in memory so signup() can turn
+ * away a taken name before hashing the password or opening the database.
+ * USERNAME_INDEX_SET is an exact hash set. USERNAME_INDEX_BLOOM keeps only
+ * a Bloom filter (about 10 bits per name) for large populations: a miss is
+ * still answered in memory, a possible hit is confirmed with one SELECT.
+ * Until the index is loaded every name counts as available, and the UNIQUE
+ * constraint stays the final word.
+ */
+typedef enum { USERNAME_INDEX_OFF, USERNAME_INDEX_SET, USERNAME_INDEX_BLOOM } username_index_mode;
+
+/* Loads the index in the mode named by STOCKSIM_USERNAME_INDEX (set, bloom or off; default set). */
+int init_username_index(void);
+int load_username_index(username_index_mode mode);
+
+/* 1 when the name is taken, 0 when it is free or the index is off. */
+int username_taken(const char *username);
+void add_username(const char *username);
+size_t username_index_size(void);
+
+#endif